@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "BoundingVolumes.h"
+#include "DataTypes.h"
+
+namespace dae
+{
+	void BoundingBox::Grow(const Vector3& point)
+	{
+		min = Vector3::Min(min, point);
+		max = Vector3::Max(max, point);
+	}
+
+	void BoundingBox::Grow(const BoundingBox& box)
+	{
+		min = Vector3::Min(min, box.min);
+		max = Vector3::Max(max, box.max);
+	}
+
+	Vector3 BoundingBox::GetCenter() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	Vector3 BoundingBox::GetExtents() const
+	{
+		return (max - min) * 0.5f;
+	}
+
+	BoundingBox BoundingBox::Transformed(const Matrix& matrix) const
+	{
+		// Start from the translation and add the smallest and largest contribution of every axis [Arvo 1990]
+		const Vector3 translation{ matrix.GetTranslation() };
+		BoundingBox result{ translation, translation };
+
+		for (int row{}; row < 3; ++row)
+		{
+			for (int column{}; column < 3; ++column)
+			{
+				const float a{ matrix[row][column] * min[row] };
+				const float b{ matrix[row][column] * max[row] };
+
+				result.min[column] += std::min(a, b);
+				result.max[column] += std::max(a, b);
+			}
+		}
+
+		return result;
+	}
+
+	BoundingBox BoundingBox::FromVertices(const std::vector<Vertex>& vertices)
+	{
+		BoundingBox result{};
+		for (const Vertex& vertex : vertices)
+		{
+			result.Grow(vertex.position);
+		}
+
+		return result;
+	}
+
+	BoundingSphere BoundingSphere::Transformed(const Matrix& matrix) const
+	{
+		// The radius scales with the largest scale of the matrix
+		const float maxScale
+		{
+			std::max(matrix.GetAxisX().Magnitude(), std::max(matrix.GetAxisY().Magnitude(), matrix.GetAxisZ().Magnitude()))
+		};
+
+		return BoundingSphere{ matrix.TransformPoint(center), radius * maxScale };
+	}
+
+	BoundingSphere BoundingSphere::FromVertices(const std::vector<Vertex>& vertices, const BoundingBox& boundingBox)
+	{
+		// Center the sphere in the box and make it big enough to hold the furthest vertex
+		BoundingSphere result{ boundingBox.GetCenter(), 0.0f };
+
+		float maxSqrDistance{};
+		for (const Vertex& vertex : vertices)
+		{
+			maxSqrDistance = std::max(maxSqrDistance, (vertex.position - result.center).SqrMagnitude());
+		}
+		result.radius = sqrtf(maxSqrDistance);
+
+		return result;
+	}
+
+	float Plane::GetSignedDistance(const Vector3& point) const
+	{
+		return Vector3::Dot(normal, point) + distance;
+	}
+
+	bool Frustum::IsOutside(const BoundingSphere& sphere) const
+	{
+		for (const Plane& plane : planes)
+		{
+			if (plane.GetSignedDistance(sphere.center) < -sphere.radius) return true;
+		}
+
+		return false;
+	}
+
+	bool Frustum::IsOutside(const BoundingBox& box) const
+	{
+		const Vector3 center{ box.GetCenter() };
+		const Vector3 extents{ box.GetExtents() };
+
+		for (const Plane& plane : planes)
+		{
+			// The projected radius of the box onto the plane normal
+			const float radius{ extents.x * abs(plane.normal.x) + extents.y * abs(plane.normal.y) + extents.z * abs(plane.normal.z) };
+
+			if (plane.GetSignedDistance(center) < -radius) return true;
+		}
+
+		return false;
+	}
+
+	bool Frustum::Contains(const BoundingBox& box) const
+	{
+		const Vector3 center{ box.GetCenter() };
+		const Vector3 extents{ box.GetExtents() };
+
+		for (const Plane& plane : planes)
+		{
+			// The whole box has to be on the inner side of every plane
+			const float radius{ extents.x * abs(plane.normal.x) + extents.y * abs(plane.normal.y) + extents.z * abs(plane.normal.z) };
+
+			if (plane.GetSignedDistance(center) < radius) return false;
+		}
+
+		return true;
+	}
+
+	Frustum Frustum::FromViewProjection(const Matrix& viewProjectionMatrix)
+	{
+		// A point is transformed as p * M, so the clip coordinates are the dot products with the columns of M
+		auto getColumn = [&](int column)
+			{
+				return Vector4
+				{
+					viewProjectionMatrix[0][column],
+					viewProjectionMatrix[1][column],
+					viewProjectionMatrix[2][column],
+					viewProjectionMatrix[3][column]
+				};
+			};
+
+		const Vector4 column0{ getColumn(0) };
+		const Vector4 column1{ getColumn(1) };
+		const Vector4 column2{ getColumn(2) };
+		const Vector4 column3{ getColumn(3) };
+
+		Frustum frustum{};
+		const Vector4 planeEquations[NrPlanes]
+		{
+			column3 + column0,	// -w <= x
+			column3 - column0,	// x <= w
+			column3 + column1,	// -w <= y
+			column3 - column1,	// y <= w
+			column2,			// 0 <= z
+			column3 - column2	// z <= w
+		};
+
+		for (int planeIdx{}; planeIdx < NrPlanes; ++planeIdx)
+		{
+			// Normalize the plane so the signed distances are in world units
+			const Vector4& equation{ planeEquations[planeIdx] };
+			const float length{ Vector3{ equation.x, equation.y, equation.z }.Magnitude() };
+
+			frustum.planes[planeIdx].normal = Vector3{ equation.x, equation.y, equation.z } / length;
+			frustum.planes[planeIdx].distance = equation.w / length;
+		}
+
+		return frustum;
+	}
+}
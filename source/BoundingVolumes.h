@@ -0,0 +1,67 @@
+#pragma once
+#include <cfloat>
+#include <vector>
+#include "Math.h"
+
+namespace dae
+{
+	struct Vertex;
+
+	struct BoundingBox
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const Vector3& point);
+		void Grow(const BoundingBox& box);
+		Vector3 GetCenter() const;
+		Vector3 GetExtents() const;
+
+		// Returns the axis aligned box that encloses this box after transforming it
+		BoundingBox Transformed(const Matrix& matrix) const;
+
+		static BoundingBox FromVertices(const std::vector<Vertex>& vertices);
+	};
+
+	struct BoundingSphere
+	{
+		Vector3 center{};
+		float radius{};
+
+		BoundingSphere Transformed(const Matrix& matrix) const;
+
+		static BoundingSphere FromVertices(const std::vector<Vertex>& vertices, const BoundingBox& boundingBox);
+	};
+
+	struct Plane
+	{
+		Vector3 normal{};
+		float distance{};
+
+		float GetSignedDistance(const Vector3& point) const;
+	};
+
+	struct Frustum
+	{
+		enum PlaneIdx
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			NrPlanes
+		};
+
+		Plane planes[NrPlanes]{};
+
+		bool IsOutside(const BoundingSphere& sphere) const;
+		bool IsOutside(const BoundingBox& box) const;
+		// Returns true when the box is completely inside the frustum
+		bool Contains(const BoundingBox& box) const;
+
+		// Extracts the planes from a (row-major, row-vector) view projection matrix [Gribb & Hartmann]
+		static Frustum FromViewProjection(const Matrix& viewProjectionMatrix);
+	};
+}
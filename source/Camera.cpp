@@ -10,6 +10,9 @@ namespace dae
 
 		// Needs to be called last because ChangeFOV calls CalculateProjectionMatrix which needs the aspectRatio
 		ChangeFOV(_fovAngle);
+
+		// Update only recalculates the view matrix when the camera moves
+		CalculateViewMatrix();
 	}
 
 	void Camera::CalculateViewMatrix()
@@ -26,6 +29,7 @@ namespace dae
 		};
 
 		m_ViewMatrix = Matrix::Inverse(m_InvViewMatrix);
+		++m_Version;
 
 		//ViewMatrix => Matrix::CreateLookAtLH(...) [not implemented yet]
 		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
@@ -34,6 +38,7 @@ namespace dae
 	void Camera::CalculateProjectionMatrix()
 	{
 		m_ProjectionMatrix = Matrix::CreatePerspectiveFovLH(m_Fov, m_AspectRatio, m_NearPlane, m_FarPlane);
+		++m_Version;
 		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixperspectivefovlh
 	}
 
@@ -59,6 +64,8 @@ namespace dae
 
 		// The total movement of this frame
 		Vector3 direction{};
+		const float previousPitch{ m_TotalPitch };
+		const float previousYaw{ m_TotalYaw };
 
 		// Calculate new position with keyboard inputs
 		direction += (pKeyboardState[SDL_SCANCODE_W] || pKeyboardState[SDL_SCANCODE_UP]) * m_Forward * keyboardMovementSpeed * deltaTime;
@@ -87,6 +94,9 @@ namespace dae
 		const float speedUpFactor{ 4.0f };
 		direction *= 1.0f + pKeyboardState[SDL_SCANCODE_LSHIFT] * (speedUpFactor - 1.0f);
 
+		// Keep the matrices (and the version) when the camera did not move or rotate
+		if (direction.SqrMagnitude() == 0.0f && m_TotalPitch == previousPitch && m_TotalYaw == previousYaw) return;
+
 		// Apply the direction to the current position
 		m_Origin += direction;
 
@@ -22,6 +22,9 @@ namespace dae
 		Matrix& GetInverseViewMatrix() { return m_InvViewMatrix; };
 		Matrix& GetProjectionMatrix() { return m_ProjectionMatrix; };
 
+		// Increases every time the view or projection matrix changes, so renderers can tell when cached results are outdated
+		uint32_t GetVersion() const { return m_Version; };
+
 
 	private:
 		Vector3 m_Origin{};
@@ -44,6 +47,8 @@ namespace dae
 		Matrix m_ViewMatrix{};
 		Matrix m_ProjectionMatrix{};
 
+		uint32_t m_Version{};
+
 		void CalculateViewMatrix();
 		void CalculateProjectionMatrix();
 	};
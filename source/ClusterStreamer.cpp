@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "ClusterStreamer.h"
+#include "MeshOptimizer.h"
+#include <filesystem>
+
+namespace dae
+{
+	uint64_t ClusterStreamer::GetSourceStamp(const std::string& sourceFilePath)
+	{
+		std::error_code error{};
+		const auto lastWriteTime{ std::filesystem::last_write_time(sourceFilePath, error) };
+		if (error) return 0;
+		const uintmax_t fileSize{ std::filesystem::file_size(sourceFilePath, error) };
+		if (error) return 0;
+
+		// Mix the size in, so a copy with an older time but other contents is noticed too
+		return static_cast<uint64_t>(lastWriteTime.time_since_epoch().count()) ^ (static_cast<uint64_t>(fileSize) << 40);
+	}
+
+	bool ClusterStreamer::WriteClusterFile(const std::string& filePath, const std::string& sourceFilePath, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::ofstream file{ filePath, std::ios::binary };
+		if (!file) return false;
+
+		// Neighbouring triangles end up in the same cluster when they are in vertex cache order
+		std::vector<uint32_t> optimizedIndices{ indices };
+		MeshOptimizer::OptimizeVertexCache(optimizedIndices, vertices.size());
+		const std::vector<Meshlet> meshlets{ MeshOptimizer::BuildMeshlets(vertices, optimizedIndices) };
+
+		const BoundingBox boundingBox{ BoundingBox::FromVertices(vertices) };
+		const uint32_t clusterCount{ static_cast<uint32_t>(meshlets.size()) };
+
+		// Collects the unique vertices of a cluster and converts its indices to the local ones
+		constexpr uint32_t noLocalIdx{ UINT32_MAX };
+		std::vector<uint32_t> localVertexIdx(vertices.size(), noLocalIdx);
+		std::vector<Vertex> clusterVertices{};
+		std::vector<uint8_t> clusterIndices{};
+		auto collectCluster = [&](const Meshlet& meshlet)
+			{
+				clusterVertices.clear();
+				clusterIndices.clear();
+				for (uint32_t idx{ meshlet.indexOffset }; idx < meshlet.indexOffset + meshlet.triangleCount * 3; ++idx)
+				{
+					const uint32_t vertexIdx{ optimizedIndices[idx] };
+					if (localVertexIdx[vertexIdx] == noLocalIdx)
+					{
+						localVertexIdx[vertexIdx] = static_cast<uint32_t>(clusterVertices.size());
+						clusterVertices.push_back(vertices[vertexIdx]);
+					}
+					clusterIndices.push_back(static_cast<uint8_t>(localVertexIdx[vertexIdx]));
+				}
+
+				// Reset the lookup for the next cluster
+				for (uint32_t idx{ meshlet.indexOffset }; idx < meshlet.indexOffset + meshlet.triangleCount * 3; ++idx)
+				{
+					localVertexIdx[optimizedIndices[idx]] = noLocalIdx;
+				}
+			};
+
+		// The table stores where the page of every cluster starts, the pages follow the table
+		std::vector<ClusterInfo> clusters(clusterCount);
+		const uint64_t sourceStamp{ GetSourceStamp(sourceFilePath) };
+		uint64_t fileOffset{ sizeof(FileMagic) + sizeof(FileVersion) + sizeof(sourceStamp) + sizeof(clusterCount) + sizeof(BoundingBox) + ClusterRecordSize * clusterCount };
+		for (uint32_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+		{
+			collectCluster(meshlets[clusterIdx]);
+
+			ClusterInfo& cluster{ clusters[clusterIdx] };
+			cluster.meshlet = meshlets[clusterIdx];
+			cluster.meshlet.indexOffset = 0;
+			cluster.fileOffset = fileOffset;
+			cluster.vertexCount = static_cast<uint32_t>(clusterVertices.size());
+
+			fileOffset += sizeof(VertexQuantized) * clusterVertices.size() + clusterIndices.size();
+		}
+
+		file.write(reinterpret_cast<const char*>(&FileMagic), sizeof(FileMagic));
+		file.write(reinterpret_cast<const char*>(&FileVersion), sizeof(FileVersion));
+		file.write(reinterpret_cast<const char*>(&sourceStamp), sizeof(sourceStamp));
+		file.write(reinterpret_cast<const char*>(&clusterCount), sizeof(clusterCount));
+		file.write(reinterpret_cast<const char*>(&boundingBox), sizeof(BoundingBox));
+
+		// Only the fields that are known when the file is written are stored
+		for (const ClusterInfo& cluster : clusters)
+		{
+			file.write(reinterpret_cast<const char*>(&cluster.meshlet), sizeof(Meshlet));
+			file.write(reinterpret_cast<const char*>(&cluster.fileOffset), sizeof(cluster.fileOffset));
+			file.write(reinterpret_cast<const char*>(&cluster.vertexCount), sizeof(cluster.vertexCount));
+		}
+
+		// Every page holds the quantized vertices of the cluster followed by its local indices
+		for (const Meshlet& meshlet : meshlets)
+		{
+			collectCluster(meshlet);
+
+			const std::vector<VertexQuantized> quantizedVertices{ MeshOptimizer::QuantizeVertices(clusterVertices, boundingBox) };
+			file.write(reinterpret_cast<const char*>(quantizedVertices.data()), sizeof(VertexQuantized) * quantizedVertices.size());
+			file.write(reinterpret_cast<const char*>(clusterIndices.data()), clusterIndices.size());
+		}
+
+		std::cout << filePath << ": wrote " << clusterCount << " clusters, " << fileOffset << " bytes\n";
+		return file.good();
+	}
+
+	bool ClusterStreamer::Open(const std::string& filePath, const std::string& sourceFilePath, size_t memoryBudget)
+	{
+		m_File = std::ifstream{ filePath, std::ios::binary };
+		if (!m_File) return false;
+
+		uint32_t magic{};
+		uint32_t version{};
+		uint64_t sourceStamp{};
+		uint32_t clusterCount{};
+		m_File.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		m_File.read(reinterpret_cast<char*>(&version), sizeof(version));
+		m_File.read(reinterpret_cast<char*>(&sourceStamp), sizeof(sourceStamp));
+		m_File.read(reinterpret_cast<char*>(&clusterCount), sizeof(clusterCount));
+		if (!m_File || magic != FileMagic || version != FileVersion) return false;
+
+		// A cluster file of another version of the source is out of date
+		if (sourceStamp != GetSourceStamp(sourceFilePath))
+		{
+			std::cout << filePath << ": out of date with " << sourceFilePath << "\n";
+			m_File.close();
+			return false;
+		}
+
+		// Only the table is read, the pages stay on disk until they are requested
+		m_File.read(reinterpret_cast<char*>(&m_BoundingBox), sizeof(BoundingBox));
+		m_Clusters.assign(clusterCount, ClusterInfo{});
+		for (ClusterInfo& cluster : m_Clusters)
+		{
+			m_File.read(reinterpret_cast<char*>(&cluster.meshlet), sizeof(Meshlet));
+			m_File.read(reinterpret_cast<char*>(&cluster.fileOffset), sizeof(cluster.fileOffset));
+			m_File.read(reinterpret_cast<char*>(&cluster.vertexCount), sizeof(cluster.vertexCount));
+		}
+		if (!m_File) return false;
+
+		// Never allocate more slots than there are clusters
+		const size_t slotSize{ sizeof(Vertex) * MeshOptimizer::MaxMeshletVertices + MeshOptimizer::MaxMeshletTriangles * 3 };
+		m_SlotCount = static_cast<uint32_t>(std::clamp(memoryBudget / slotSize, size_t{ 1 }, size_t{ clusterCount }));
+		m_SlotVertices.resize(static_cast<size_t>(m_SlotCount) * MeshOptimizer::MaxMeshletVertices);
+		m_SlotIndices.resize(static_cast<size_t>(m_SlotCount) * MeshOptimizer::MaxMeshletTriangles * 3);
+		m_SlotClusters.assign(m_SlotCount, InvalidIdx);
+
+		std::cout << filePath << ": " << clusterCount << " clusters, " << m_SlotCount << " resident at most ("
+			<< slotSize * m_SlotCount << " bytes)\n";
+		return true;
+	}
+
+	void ClusterStreamer::RequestCluster(uint32_t clusterIdx, float priority)
+	{
+		ClusterInfo& cluster{ m_Clusters[clusterIdx] };
+		if (cluster.lastRequestedFrame == m_FrameIdx) return;
+
+		cluster.lastRequestedFrame = m_FrameIdx;
+		if (cluster.slotIdx == InvalidIdx) m_PendingClusters.emplace_back(priority, clusterIdx);
+	}
+
+	void ClusterStreamer::LoadRequestedClusters()
+	{
+		if (!m_PendingClusters.empty())
+		{
+			// Free slots are used first, then the slots of the clusters that were requested the longest time ago
+			// Clusters that were requested this frame are never replaced, when the budget is too small for them the rest stays on disk
+			std::vector<std::pair<uint32_t, uint32_t>> evictableSlots{};
+			for (uint32_t slotIdx{}; slotIdx < m_SlotCount; ++slotIdx)
+			{
+				const uint32_t clusterIdx{ m_SlotClusters[slotIdx] };
+				const uint32_t lastRequestedFrame{ clusterIdx == InvalidIdx ? 0 : m_Clusters[clusterIdx].lastRequestedFrame };
+				if (lastRequestedFrame < m_FrameIdx) evictableSlots.emplace_back(lastRequestedFrame, slotIdx);
+			}
+
+			const size_t loadCount{ std::min({ m_PendingClusters.size(), evictableSlots.size(), size_t{ MaxLoadsPerFrame } }) };
+
+			// The closest clusters are loaded first
+			std::partial_sort(m_PendingClusters.begin(), m_PendingClusters.begin() + loadCount, m_PendingClusters.end());
+			std::partial_sort(evictableSlots.begin(), evictableSlots.begin() + loadCount, evictableSlots.end());
+
+			for (size_t loadIdx{}; loadIdx < loadCount; ++loadIdx)
+			{
+				if (!LoadCluster(m_PendingClusters[loadIdx].second, evictableSlots[loadIdx].second)) break;
+			}
+
+			if (loadCount > 0) ++m_ResidencyVersion;
+			m_PendingClusters.clear();
+		}
+
+		++m_FrameIdx;
+	}
+
+	bool ClusterStreamer::LoadCluster(uint32_t clusterIdx, uint32_t slotIdx)
+	{
+		ClusterInfo& cluster{ m_Clusters[clusterIdx] };
+
+		// Evict the cluster that used the slot
+		const uint32_t evictedClusterIdx{ m_SlotClusters[slotIdx] };
+		if (evictedClusterIdx != InvalidIdx) m_Clusters[evictedClusterIdx].slotIdx = InvalidIdx;
+		m_SlotClusters[slotIdx] = InvalidIdx;
+
+		// Read the page of the cluster
+		m_ReadVertices.resize(cluster.vertexCount);
+		uint8_t* pIndices{ m_SlotIndices.data() + static_cast<size_t>(slotIdx) * MeshOptimizer::MaxMeshletTriangles * 3 };
+
+		m_File.seekg(static_cast<std::streamoff>(cluster.fileOffset));
+		m_File.read(reinterpret_cast<char*>(m_ReadVertices.data()), sizeof(VertexQuantized) * cluster.vertexCount);
+		m_File.read(reinterpret_cast<char*>(pIndices), cluster.meshlet.triangleCount * 3);
+		if (!m_File)
+		{
+			m_File.clear();
+			std::cout << "Failed to read cluster " << clusterIdx << "\n";
+			return false;
+		}
+
+		// Decode the vertices once, so they can be transformed as often as the cluster stays resident
+		const Vector3 positionScale{ m_BoundingBox.max - m_BoundingBox.min };
+		Vertex* pVertices{ m_SlotVertices.data() + static_cast<size_t>(slotIdx) * MeshOptimizer::MaxMeshletVertices };
+		for (uint32_t vertexIdx{}; vertexIdx < cluster.vertexCount; ++vertexIdx)
+		{
+			pVertices[vertexIdx] = MeshOptimizer::DequantizeVertex(m_ReadVertices[vertexIdx], positionScale, m_BoundingBox.min);
+		}
+
+		cluster.slotIdx = slotIdx;
+		m_SlotClusters[slotIdx] = clusterIdx;
+		return true;
+	}
+
+	uint32_t ClusterStreamer::GetClusterCount() const
+	{
+		return static_cast<uint32_t>(m_Clusters.size());
+	}
+
+	const Meshlet& ClusterStreamer::GetCluster(uint32_t clusterIdx) const
+	{
+		return m_Clusters[clusterIdx].meshlet;
+	}
+
+	bool ClusterStreamer::IsResident(uint32_t clusterIdx) const
+	{
+		return m_Clusters[clusterIdx].slotIdx != InvalidIdx;
+	}
+
+	const Vertex* ClusterStreamer::GetClusterVertices(uint32_t clusterIdx) const
+	{
+		return m_SlotVertices.data() + static_cast<size_t>(m_Clusters[clusterIdx].slotIdx) * MeshOptimizer::MaxMeshletVertices;
+	}
+
+	uint32_t ClusterStreamer::GetClusterVertexCount(uint32_t clusterIdx) const
+	{
+		return m_Clusters[clusterIdx].vertexCount;
+	}
+
+	const uint8_t* ClusterStreamer::GetClusterIndices(uint32_t clusterIdx) const
+	{
+		return m_SlotIndices.data() + static_cast<size_t>(m_Clusters[clusterIdx].slotIdx) * MeshOptimizer::MaxMeshletTriangles * 3;
+	}
+
+	const BoundingBox& ClusterStreamer::GetBoundingBox() const
+	{
+		return m_BoundingBox;
+	}
+
+	uint32_t ClusterStreamer::GetResidencyVersion() const
+	{
+		return m_ResidencyVersion;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "DataTypes.h"
+
+namespace dae
+{
+	// Keeps a fixed amount of clusters of a mesh in memory and pages the others in from a cluster file when they are requested
+	// The cluster file stores a table with the bounds of every cluster, followed by the quantized vertices and local indices of every cluster
+	// It also stores the modification time and size of the OBJ it was built from, so it is built again when the OBJ changes
+	class ClusterStreamer final
+	{
+	public:
+		// Splits the triangle list into clusters and writes them to a cluster file
+		static bool WriteClusterFile(const std::string& filePath, const std::string& sourceFilePath, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		// Reads the cluster table, the memory budget (in bytes) decides how many clusters can be resident at the same time
+		// Fails when the file does not exist or was built from another version of the source file
+		bool Open(const std::string& filePath, const std::string& sourceFilePath, size_t memoryBudget);
+
+		// Marks a cluster as needed this frame, clusters that are not resident are loaded by LoadRequestedClusters in order of priority (lowest first)
+		void RequestCluster(uint32_t clusterIdx, float priority);
+
+		// Loads the requested clusters that are not resident yet, replacing the clusters that were used the longest time ago
+		void LoadRequestedClusters();
+
+		uint32_t GetClusterCount() const;
+		const Meshlet& GetCluster(uint32_t clusterIdx) const;
+		bool IsResident(uint32_t clusterIdx) const;
+		// The vertices and local indices (triangleCount * 3 of them) of a resident cluster
+		const Vertex* GetClusterVertices(uint32_t clusterIdx) const;
+		uint32_t GetClusterVertexCount(uint32_t clusterIdx) const;
+		const uint8_t* GetClusterIndices(uint32_t clusterIdx) const;
+
+		const BoundingBox& GetBoundingBox() const;
+		// Increases every time clusters are loaded or evicted
+		uint32_t GetResidencyVersion() const;
+
+	private:
+		static constexpr uint32_t FileMagic{ 0x54534C43 }; // "CLST"
+		static constexpr uint32_t FileVersion{ 2 };
+		static constexpr uint32_t InvalidIdx{ UINT32_MAX };
+
+		// The maximum amount of clusters read from disk per frame, the rest is loaded during the next frames
+		static constexpr uint32_t MaxLoadsPerFrame{ 256 };
+
+		struct ClusterInfo
+		{
+			// The bounds and normal cone, the index offset is not used
+			Meshlet meshlet{};
+			uint64_t fileOffset{};
+			uint32_t vertexCount{};
+
+			// Only known at runtime, they are not stored in the file
+			uint32_t slotIdx{ InvalidIdx };
+			uint32_t lastRequestedFrame{};
+		};
+		// The size of the fields of a cluster that are stored in the table
+		static constexpr size_t ClusterRecordSize{ sizeof(Meshlet) + sizeof(uint64_t) + sizeof(uint32_t) };
+
+		// Changes when the source file is modified, zero when it cannot be read
+		static uint64_t GetSourceStamp(const std::string& sourceFilePath);
+
+		std::ifstream m_File{};
+		BoundingBox m_BoundingBox{};
+		std::vector<ClusterInfo> m_Clusters{};
+
+		// Every slot can hold one cluster of the maximum size, all slots are allocated up front so the memory use never grows
+		uint32_t m_SlotCount{};
+		std::vector<Vertex> m_SlotVertices{};
+		std::vector<uint8_t> m_SlotIndices{};
+		std::vector<uint32_t> m_SlotClusters{};
+
+		// The clusters that were requested this frame but are not resident
+		std::vector<std::pair<float, uint32_t>> m_PendingClusters{};
+		std::vector<VertexQuantized> m_ReadVertices{};
+
+		// Starts at one, so clusters that were never requested are older than every frame
+		uint32_t m_FrameIdx{ 1 };
+		uint32_t m_ResidencyVersion{};
+
+		bool LoadCluster(uint32_t clusterIdx, uint32_t slotIdx);
+	};
+}
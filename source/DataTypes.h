@@ -1,5 +1,6 @@
 #pragma once
 #include "Math.h"
+#include "BoundingVolumes.h"
 
 namespace dae
 {
@@ -13,6 +14,24 @@ namespace dae
 		Vector3 viewDirection{}; //W4
 	};
 
+	// Compact vertex (20 bytes instead of 68) for meshes that use VertexFormat::Quantized
+	struct VertexQuantized
+	{
+		// 16-bit normalized position inside the bounding box of the mesh, the fourth component is padding
+		uint16_t position[4]{};
+		// Octahedral encoded unit vectors as 16-bit signed normalized pairs
+		int16_t normal[2]{};
+		int16_t tangent[2]{};
+		// Half floats
+		uint16_t uv[2]{};
+	};
+
+	enum class VertexFormat
+	{
+		Full,
+		Quantized
+	};
+
 	struct Vertex_Out
 	{
 		Vector4 position{};
@@ -23,6 +42,33 @@ namespace dae
 		Vector3 viewDirection{};
 	};
 
+	// A cluster of neighbouring triangles that is culled as a whole
+	struct Meshlet
+	{
+		// The triangles of the meshlet are stored contiguously in the index buffer of the mesh
+		uint32_t indexOffset{};
+		uint32_t triangleCount{};
+
+		BoundingSphere boundingSphere{};
+
+		// Normal cone: every triangle normal is within the cone around the axis, the cutoff is the sine of the cone angle
+		// A cutoff of 1 means the cone is too wide to ever cull the meshlet
+		Vector3 coneAxis{};
+		float coneCutoff{ 1.0f };
+	};
+
+	// A level of detail of a mesh, every LOD uses its own range of the shared index buffer and meshlets
+	struct MeshLod
+	{
+		uint32_t indexOffset{};
+		uint32_t indexCount{};
+		uint32_t meshletOffset{};
+		uint32_t meshletCount{};
+
+		// The largest distance (in object space units) the simplified surface deviates from the full resolution mesh
+		float error{};
+	};
+
 	enum class PrimitiveTopology
 	{
 		TriangleList,
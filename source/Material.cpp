@@ -10,6 +10,31 @@ namespace dae
 		m_pTechnique = m_pEffect->GetTechniqueByName("DefaultTechnique");
 		if (!m_pTechnique->IsValid()) std::wcout << L"Technique not valid\n";
 
+		// Save the technique that decodes quantized vertices as a member variable
+		m_pQuantizedTechnique = m_pEffect->GetTechniqueByName("QuantizedTechnique");
+		if (!m_pQuantizedTechnique->IsValid()) std::wcout << L"m_pQuantizedTechnique not valid\n";
+
+		// Save the techniques that read the world matrix of every instance as member variables
+		m_pInstancedTechnique = m_pEffect->GetTechniqueByName("InstancedTechnique");
+		if (!m_pInstancedTechnique->IsValid()) std::wcout << L"m_pInstancedTechnique not valid\n";
+
+		m_pQuantizedInstancedTechnique = m_pEffect->GetTechniqueByName("QuantizedInstancedTechnique");
+		if (!m_pQuantizedInstancedTechnique->IsValid()) std::wcout << L"m_pQuantizedInstancedTechnique not valid\n";
+
+		// Save the instance variables of the effect as member variables
+		m_pInstancesVariable = m_pEffect->GetVariableByName("gInstances")->AsShaderResource();
+		if (!m_pInstancesVariable->IsValid()) std::wcout << L"m_pInstancesVariable not valid\n";
+
+		m_pMatViewProjVariable = m_pEffect->GetVariableByName("gViewProj")->AsMatrix();
+		if (!m_pMatViewProjVariable->IsValid()) std::wcout << L"m_pMatViewProjVariable not valid\n";
+
+		// Save the position dequantization variables of the effect as member variables
+		m_pPositionScaleVariable = m_pEffect->GetVariableByName("gPositionScale")->AsVector();
+		if (!m_pPositionScaleVariable->IsValid()) std::wcout << L"m_pPositionScaleVariable not valid\n";
+
+		m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+		if (!m_pPositionOffsetVariable->IsValid()) std::wcout << L"m_pPositionOffsetVariable not valid\n";
+
 		// Save the worldviewprojection variable of the effect as a member variable
 		m_pMatWorldViewProjVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
 		if (!m_pMatWorldViewProjVariable->IsValid()) std::wcout << L"m_pMatWorldViewProjVariable not valid\n";
@@ -38,6 +63,12 @@ namespace dae
 			m_pMatWorldViewProjVariable->SetMatrix(reinterpret_cast<const float*>(&matrix));
 			break;
 		}
+		case dae::MatrixType::ViewProjection:
+		{
+			// Set the current matrix to the viewprojection variable of the effect, used by the instanced techniques
+			m_pMatViewProjVariable->SetMatrix(reinterpret_cast<const float*>(&matrix));
+			break;
+		}
 		}
 	}
 
@@ -46,12 +77,18 @@ namespace dae
 		return m_pEffect;
 	}
 
-	ID3DX11EffectTechnique* Material::GetTechnique() const
+	ID3DX11EffectTechnique* Material::GetTechnique(VertexFormat vertexFormat, bool isInstanced) const
+	{
+		if (isInstanced) return vertexFormat == VertexFormat::Quantized ? m_pQuantizedInstancedTechnique : m_pInstancedTechnique;
+		return vertexFormat == VertexFormat::Quantized ? m_pQuantizedTechnique : m_pTechnique;
+	}
+
+	bool Material::IsTransparent() const
 	{
-		return m_pTechnique;
+		return false;
 	}
 
-	ID3D11InputLayout* Material::LoadInputLayout(ID3D11Device* pDevice)
+	ID3D11InputLayout* Material::LoadInputLayout(ID3D11Device* pDevice, VertexFormat vertexFormat)
 	{
 		// Create vertex layout
 		static constexpr uint32_t numElements{ 4 };
@@ -77,9 +114,25 @@ namespace dae
 		vertexDesc[3].AlignedByteOffset = 36;
 		vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
+		// The quantized layout matches VertexQuantized, the effect decodes it in the vertex shader
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			vertexDesc[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+			vertexDesc[0].AlignedByteOffset = 0;
+
+			vertexDesc[2].Format = DXGI_FORMAT_R16G16_SNORM;
+			vertexDesc[2].AlignedByteOffset = 8;
+
+			vertexDesc[1].Format = DXGI_FORMAT_R16G16_SNORM;
+			vertexDesc[1].AlignedByteOffset = 12;
+
+			vertexDesc[3].Format = DXGI_FORMAT_R16G16_FLOAT;
+			vertexDesc[3].AlignedByteOffset = 16;
+		}
+
 		// Create input layout
 		D3DX11_PASS_DESC passDesc{};
-		m_pTechnique->GetPassByIndex(0)->GetDesc(&passDesc);
+		GetTechnique(vertexFormat)->GetPassByIndex(0)->GetDesc(&passDesc);
 
 		ID3D11InputLayout* pInputLayout;
 
@@ -96,6 +149,21 @@ namespace dae
 		return pInputLayout;
 	}
 
+	void Material::SetPositionDequantization(const Vector3& positionScale, const Vector3& positionOffset)
+	{
+		const Vector4 scale{ positionScale, 0.0f };
+		const Vector4 offset{ positionOffset, 0.0f };
+
+		m_pPositionScaleVariable->SetFloatVector(reinterpret_cast<const float*>(&scale));
+		m_pPositionOffsetVariable->SetFloatVector(reinterpret_cast<const float*>(&offset));
+	}
+
+	void Material::SetInstanceBuffer(ID3D11ShaderResourceView* pInstanceBufferView)
+	{
+		HRESULT hr{ m_pInstancesVariable->SetResource(pInstanceBufferView) };
+		if (FAILED(hr)) std::wcout << L"Failed to change instance buffer";
+	}
+
 	void Material::SetSampleState(ID3D11SamplerState* pSampleState)
 	{
 		HRESULT hr{ m_pSamplerStateVariable->SetSampler(0, pSampleState) };
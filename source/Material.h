@@ -1,4 +1,5 @@
 #pragma once
+#include "DataTypes.h"
 
 namespace dae
 {
@@ -18,14 +19,24 @@ namespace dae
 		virtual void SetMatrix(MatrixType type, const Matrix& matrix);
 		virtual void SetTexture(Texture* pTexture) = 0;
 		ID3DX11Effect* GetEffect() const;
-		ID3DX11EffectTechnique* GetTechnique() const;
+		ID3DX11EffectTechnique* GetTechnique(VertexFormat vertexFormat = VertexFormat::Full, bool isInstanced = false) const;
+		virtual bool IsTransparent() const;
 
-		ID3D11InputLayout* LoadInputLayout(ID3D11Device* pDevice);
+		ID3D11InputLayout* LoadInputLayout(ID3D11Device* pDevice, VertexFormat vertexFormat = VertexFormat::Full);
+		void SetPositionDequantization(const Vector3& positionScale, const Vector3& positionOffset);
+		void SetInstanceBuffer(ID3D11ShaderResourceView* pInstanceBufferView);
 		void SetSampleState(ID3D11SamplerState* pSampleState);
 		void SetRasterizerState(ID3D11RasterizerState* pRasterizerState);
 	protected:
 		ID3DX11Effect* m_pEffect{};
 		ID3DX11EffectTechnique* m_pTechnique{};
+		ID3DX11EffectTechnique* m_pQuantizedTechnique{};
+		ID3DX11EffectTechnique* m_pInstancedTechnique{};
+		ID3DX11EffectTechnique* m_pQuantizedInstancedTechnique{};
+		ID3DX11EffectShaderResourceVariable* m_pInstancesVariable{};
+		ID3DX11EffectMatrixVariable* m_pMatViewProjVariable{};
+		ID3DX11EffectVectorVariable* m_pPositionScaleVariable{};
+		ID3DX11EffectVectorVariable* m_pPositionOffsetVariable{};
 		ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable{};
 		ID3DX11EffectSamplerVariable* m_pSamplerStateVariable{};
 		ID3DX11EffectRasterizerVariable* m_pRasterizerStateVariable{};
@@ -16,4 +16,10 @@ namespace dae
 	{
 		m_pDiffuseMapVariable->SetResource(pTexture->GetSRV());
 	}
+
+	bool MaterialTransparent::IsTransparent() const
+	{
+		// Transparent meshes are blended, so they have to be rendered back to front after the opaque ones
+		return true;
+	}
 }
@@ -11,6 +11,7 @@ namespace dae
 		MaterialTransparent(ID3D11Device* pDevice, const std::wstring& assetFile);
 
 		void SetTexture(Texture* pTexture);
+		virtual bool IsTransparent() const override;
 	private:
 		ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{};
 	};
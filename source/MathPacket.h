@@ -0,0 +1,170 @@
+#pragma once
+#include <emmintrin.h>
+#include "Vector3.h"
+#include "ColorRGB.h"
+
+namespace dae
+{
+	// The amount of values processed together, one per SSE lane
+	constexpr int PacketSize{ 4 };
+
+	// Raises every lane of base to the power of exponent as exp2(exponent * log2(base)), for bases in [0, 1] and exponents >= 0
+	// log2 of the mantissa uses a degree 5 polynomial (absolute error 7.4e-6) and exp2 of the fraction a degree 4 polynomial (relative error 3.5e-6)
+	// For exponents up to 25 the relative error of the result stays below 2e-4, far below the 1/255 step of an 8-bit color channel
+	// Zero to the power of zero is one, like powf
+	inline __m128 FastPow(__m128 base, __m128 exponent)
+	{
+		const __m128 zero{ _mm_setzero_ps() };
+		const __m128 one{ _mm_set1_ps(1.0f) };
+
+		// Split the base into its exponent and its mantissa in [1, 2)
+		const __m128i bits{ _mm_castps_si128(base) };
+		const __m128 baseExponent{ _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127))) };
+		const __m128 mantissa{ _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))) };
+
+		// log2(mantissa) = t * p(t) with t = mantissa - 1
+		const __m128 t{ _mm_sub_ps(mantissa, one) };
+		__m128 logPolynomial{ _mm_set1_ps(-0.0338220460f) };
+		logPolynomial = _mm_add_ps(_mm_mul_ps(logPolynomial, t), _mm_set1_ps(0.144471096f));
+		logPolynomial = _mm_add_ps(_mm_mul_ps(logPolynomial, t), _mm_set1_ps(-0.301638010f));
+		logPolynomial = _mm_add_ps(_mm_mul_ps(logPolynomial, t), _mm_set1_ps(0.468658879f));
+		logPolynomial = _mm_add_ps(_mm_mul_ps(logPolynomial, t), _mm_set1_ps(-0.720358773f));
+		logPolynomial = _mm_add_ps(_mm_mul_ps(logPolynomial, t), _mm_set1_ps(1.44268147f));
+		const __m128 log2Base{ _mm_add_ps(baseExponent, _mm_mul_ps(logPolynomial, t)) };
+
+		// Clamp to the smallest normal exponent, smaller results are zero for every 8-bit color anyway
+		const __m128 power{ _mm_max_ps(_mm_mul_ps(exponent, log2Base), _mm_set1_ps(-126.0f)) };
+
+		// Split the power into its integer part (rounded down) and the fraction in [0, 1)
+		__m128i integerPart{ _mm_cvttps_epi32(power) };
+		integerPart = _mm_add_epi32(integerPart, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(integerPart), power)));
+		const __m128 fraction{ _mm_sub_ps(power, _mm_cvtepi32_ps(integerPart)) };
+
+		// exp2(fraction) as a polynomial, exp2(integerPart) by writing the float exponent directly
+		__m128 expPolynomial{ _mm_set1_ps(0.0136703095f) };
+		expPolynomial = _mm_add_ps(_mm_mul_ps(expPolynomial, fraction), _mm_set1_ps(0.0517449978f));
+		expPolynomial = _mm_add_ps(_mm_mul_ps(expPolynomial, fraction), _mm_set1_ps(0.241604357f));
+		expPolynomial = _mm_add_ps(_mm_mul_ps(expPolynomial, fraction), _mm_set1_ps(0.692972922f));
+		expPolynomial = _mm_add_ps(_mm_mul_ps(expPolynomial, fraction), _mm_set1_ps(1.00000349f));
+		const __m128 exp2Integer{ _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(integerPart, _mm_set1_epi32(127)), 23)) };
+		const __m128 result{ _mm_mul_ps(expPolynomial, exp2Integer) };
+
+		// The logarithm is undefined for zero, those lanes are zero unless the exponent is zero too
+		const __m128 isBasePositive{ _mm_cmpgt_ps(base, zero) };
+		const __m128 isExponentZero{ _mm_cmpeq_ps(exponent, zero) };
+		return _mm_or_ps(_mm_and_ps(isBasePositive, result), _mm_andnot_ps(isBasePositive, _mm_and_ps(isExponentZero, one)));
+	}
+
+	// Four vectors, stored per component so every operation handles all of them at once
+	struct Vector3Packet
+	{
+		__m128 x{};
+		__m128 y{};
+		__m128 z{};
+
+		static Vector3Packet Splat(const Vector3& v)
+		{
+			return { _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z) };
+		}
+
+		static Vector3Packet FromLanes(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Vector3& v3)
+		{
+			return { _mm_setr_ps(v0.x, v1.x, v2.x, v3.x), _mm_setr_ps(v0.y, v1.y, v2.y, v3.y), _mm_setr_ps(v0.z, v1.z, v2.z, v3.z) };
+		}
+
+		Vector3Packet Normalized() const
+		{
+			const __m128 inverseMagnitude{ _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(Dot(*this, *this))) };
+			return *this * inverseMagnitude;
+		}
+
+		static __m128 Dot(const Vector3Packet& v1, const Vector3Packet& v2)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v1.x, v2.x), _mm_mul_ps(v1.y, v2.y)), _mm_mul_ps(v1.z, v2.z));
+		}
+
+		static __m128 DotClamped(const Vector3Packet& v1, const Vector3Packet& v2)
+		{
+			return _mm_min_ps(_mm_max_ps(Dot(v1, v2), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		}
+
+		static Vector3Packet Cross(const Vector3Packet& v1, const Vector3Packet& v2)
+		{
+			return
+			{
+				_mm_sub_ps(_mm_mul_ps(v1.y, v2.z), _mm_mul_ps(v1.z, v2.y)),
+				_mm_sub_ps(_mm_mul_ps(v1.z, v2.x), _mm_mul_ps(v1.x, v2.z)),
+				_mm_sub_ps(_mm_mul_ps(v1.x, v2.y), _mm_mul_ps(v1.y, v2.x))
+			};
+		}
+
+		static Vector3Packet Reflect(const Vector3Packet& v1, const Vector3Packet& v2)
+		{
+			return v1 - v2 * _mm_mul_ps(_mm_set1_ps(2.0f), Dot(v1, v2));
+		}
+
+		Vector3Packet operator+(const Vector3Packet& v) const
+		{
+			return { _mm_add_ps(x, v.x), _mm_add_ps(y, v.y), _mm_add_ps(z, v.z) };
+		}
+
+		Vector3Packet operator-(const Vector3Packet& v) const
+		{
+			return { _mm_sub_ps(x, v.x), _mm_sub_ps(y, v.y), _mm_sub_ps(z, v.z) };
+		}
+
+		Vector3Packet operator*(__m128 scale) const
+		{
+			return { _mm_mul_ps(x, scale), _mm_mul_ps(y, scale), _mm_mul_ps(z, scale) };
+		}
+	};
+
+	// Four colors, stored per channel
+	struct ColorRGBPacket
+	{
+		__m128 r{};
+		__m128 g{};
+		__m128 b{};
+
+		static ColorRGBPacket Splat(const ColorRGB& c)
+		{
+			return { _mm_set1_ps(c.r), _mm_set1_ps(c.g), _mm_set1_ps(c.b) };
+		}
+
+		static ColorRGBPacket FromLanes(const ColorRGB& c0, const ColorRGB& c1, const ColorRGB& c2, const ColorRGB& c3)
+		{
+			return { _mm_setr_ps(c0.r, c1.r, c2.r, c3.r), _mm_setr_ps(c0.g, c1.g, c2.g, c3.g), _mm_setr_ps(c0.b, c1.b, c2.b, c3.b) };
+		}
+
+		void MaxToOne()
+		{
+			// Divide by the largest channel of the colors where it is above one
+			const __m128 maxValue{ _mm_max_ps(r, _mm_max_ps(g, b)) };
+			const __m128 scale{ _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(maxValue, _mm_set1_ps(1.0f))) };
+			r = _mm_mul_ps(r, scale);
+			g = _mm_mul_ps(g, scale);
+			b = _mm_mul_ps(b, scale);
+		}
+
+		ColorRGBPacket operator+(const ColorRGBPacket& c) const
+		{
+			return { _mm_add_ps(r, c.r), _mm_add_ps(g, c.g), _mm_add_ps(b, c.b) };
+		}
+
+		ColorRGBPacket operator*(const ColorRGBPacket& c) const
+		{
+			return { _mm_mul_ps(r, c.r), _mm_mul_ps(g, c.g), _mm_mul_ps(b, c.b) };
+		}
+
+		ColorRGBPacket operator*(__m128 scale) const
+		{
+			return { _mm_mul_ps(r, scale), _mm_mul_ps(g, scale), _mm_mul_ps(b, scale) };
+		}
+
+		const ColorRGBPacket& operator+=(const ColorRGBPacket& c)
+		{
+			*this = *this + c;
+			return *this;
+		}
+	};
+}
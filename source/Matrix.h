@@ -7,7 +7,8 @@ namespace dae {
 	{
 		WorldViewProjection,
 		World,
-		InverseView
+		InverseView,
+		ViewProjection
 	};
 
 	struct Matrix
@@ -2,43 +2,83 @@
 #include "Mesh.h"
 #include "Utils.h"
 #include "Material.h"
+#include "MeshOptimizer.h"
+#include "ClusterStreamer.h"
+#include <stdexcept>
 
 namespace dae
 {
-	Mesh::Mesh(ID3D11Device* pDevice, const std::string& filePath, Material* pMaterial, ID3D11SamplerState* pSampleState)
-		: m_pMaterial{ pMaterial }
+	Mesh::Mesh(ID3D11Device* pDevice, const std::string& filePath, Material* pMaterial, ID3D11SamplerState* pSampleState, VertexFormat vertexFormat)
+		: m_VertexFormat{ vertexFormat }
+		, m_pMaterial{ pMaterial }
 	{
 		bool parseResult{ Utils::ParseOBJ(filePath, m_Vertices, m_Indices) };
 		if (!parseResult)
 		{
+			// The mesh stays empty, it is left out of culling so it is never drawn
 			std::cout << "Failed to load OBJ from " << filePath << "\n";
 			return;
 		}
 
+		// Reorder the indices and vertices for the post-transform cache and vertex fetching
+		OptimizeMesh(filePath);
+
+		// Calculate the object space bounds used for culling
+		m_BoundingBox = BoundingBox::FromVertices(m_Vertices);
+		m_BoundingSphere = BoundingSphere::FromVertices(m_Vertices, m_BoundingBox);
+
+		// Replace the vertices by their compact version, positions are stored relative to the bounding box
+		if (m_VertexFormat == VertexFormat::Quantized)
+		{
+			m_QuantizedVertices = MeshOptimizer::QuantizeVertices(m_Vertices, m_BoundingBox);
+			pMaterial->SetPositionDequantization(m_BoundingBox.max - m_BoundingBox.min, m_BoundingBox.min);
+
+			std::cout << "\tQuantized vertices: " << sizeof(Vertex) * m_Vertices.size() << " -> "
+				<< sizeof(VertexQuantized) * m_QuantizedVertices.size() << " bytes\n";
+
+			m_Vertices.clear();
+			m_Vertices.shrink_to_fit();
+		}
+
+		// Store the indices in 16 bits when every vertex can be addressed with them
+		// 0xFFFF is the strip cut value of D3D11, so it can not be used as a vertex index
+		if (GetVertexCount() <= UINT16_MAX)
+		{
+			m_Indices16.resize(m_Indices.size());
+			std::transform(m_Indices.begin(), m_Indices.end(), m_Indices16.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+
+			std::cout << "\t16-bit indices: " << sizeof(uint32_t) * m_Indices.size() << " -> " << sizeof(uint16_t) * m_Indices16.size() << " bytes\n";
+
+			m_Indices.clear();
+			m_Indices.shrink_to_fit();
+		}
+
 		// Create Input Layout
-		m_pInputLayout = pMaterial->LoadInputLayout(pDevice);
+		m_pInputLayout = pMaterial->LoadInputLayout(pDevice, m_VertexFormat);
 
 		// Create vertex buffer
+		const bool isQuantized{ m_VertexFormat == VertexFormat::Quantized };
+
 		D3D11_BUFFER_DESC bd{};
 		bd.Usage = D3D11_USAGE_IMMUTABLE;
-		bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(m_Vertices.size());
+		bd.ByteWidth = static_cast<uint32_t>(isQuantized ? sizeof(VertexQuantized) * m_QuantizedVertices.size() : sizeof(Vertex) * m_Vertices.size());
 		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 		bd.CPUAccessFlags = 0;
 		bd.MiscFlags = 0;
 
 		D3D11_SUBRESOURCE_DATA initData{};
-		initData.pSysMem = m_Vertices.data();
+		initData.pSysMem = isQuantized ? static_cast<const void*>(m_QuantizedVertices.data()) : static_cast<const void*>(m_Vertices.data());
 
 		HRESULT result{ pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer) };
 		if (FAILED(result)) return;
 
 		// Create index buffer
 		bd.Usage = D3D11_USAGE_IMMUTABLE;
-		bd.ByteWidth = sizeof(uint32_t) * static_cast<uint32_t>(m_Indices.size());
+		bd.ByteWidth = static_cast<uint32_t>(Uses16BitIndices() ? sizeof(uint16_t) * m_Indices16.size() : sizeof(uint32_t) * m_Indices.size());
 		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 		bd.CPUAccessFlags = 0;
 		bd.MiscFlags = 0;
-		initData.pSysMem = m_Indices.data();
+		initData.pSysMem = Uses16BitIndices() ? static_cast<const void*>(m_Indices16.data()) : static_cast<const void*>(m_Indices.data());
 
 		result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 		if (FAILED(result)) return;
@@ -46,8 +86,38 @@ namespace dae
 		if (pSampleState) SetSamplerState(pSampleState);
 	}
 
+	Mesh::Mesh(const std::string& filePath, const std::string& clusterFilePath, size_t memoryBudget, Material* pMaterial)
+		: m_pClusterStreamer{ std::make_unique<ClusterStreamer>() }
+		, m_pMaterial{ pMaterial }
+	{
+		// Split the mesh into clusters once, later runs only read the cluster table
+		if (!m_pClusterStreamer->Open(clusterFilePath, filePath, memoryBudget))
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			if (!Utils::ParseOBJ(filePath, vertices, indices) || !ClusterStreamer::WriteClusterFile(clusterFilePath, filePath, vertices, indices) ||
+				!m_pClusterStreamer->Open(clusterFilePath, filePath, memoryBudget))
+			{
+				// A mesh without LODs and bounds cannot be culled or drawn, so it is never created
+				throw std::runtime_error{ "Failed to stream OBJ from " + filePath };
+			}
+		}
+
+		// Calculate the object space bounds used for culling from the bounds in the cluster file
+		m_BoundingBox = m_pClusterStreamer->GetBoundingBox();
+		m_BoundingSphere = BoundingSphere{ m_BoundingBox.GetCenter(), m_BoundingBox.GetExtents().Magnitude() };
+
+		// Every cluster belongs to the one full resolution LOD
+		MeshLod lod{};
+		lod.meshletCount = m_pClusterStreamer->GetClusterCount();
+		m_Lods.push_back(lod);
+	}
+
 	Mesh::~Mesh()
 	{
+		if (m_pInstanceBufferView) m_pInstanceBufferView->Release();
+		if (m_pInstanceBuffer) m_pInstanceBuffer->Release();
+
 		if (m_pIndexBuffer) m_pIndexBuffer->Release();
 		if (m_pVertexBuffer) m_pVertexBuffer->Release();
 
@@ -56,10 +126,90 @@ namespace dae
 		delete m_pMaterial;
 	}
 
+	void Mesh::OptimizeMesh(const std::string& filePath)
+	{
+		const MeshOptimizer::VertexCacheStatistics statisticsBefore{ MeshOptimizer::AnalyzeVertexCache(m_Indices, m_Vertices.size()) };
+
+		// First optimize the triangle order of the full resolution mesh, then sort its clusters to reduce overdraw
+		MeshOptimizer::OptimizeVertexCache(m_Indices, m_Vertices.size());
+		const MeshOptimizer::OverdrawStatistics overdrawBefore{ MeshOptimizer::AnalyzeOverdraw(m_Vertices, m_Indices) };
+		MeshOptimizer::OptimizeOverdraw(m_Indices, m_Vertices);
+		const MeshOptimizer::OverdrawStatistics overdrawAfter{ MeshOptimizer::AnalyzeOverdraw(m_Vertices, m_Indices) };
+
+		// Simplify the full resolution mesh to generate the LODs, so the errors are measured against the original surface
+		std::vector<std::vector<uint32_t>> lodIndices{ m_Indices };
+		std::vector<float> lodErrors{ 0.0f };
+		while (lodIndices.size() < MeshOptimizer::MaxLodCount)
+		{
+			const size_t targetIndexCount{ lodIndices.back().size() / 2 / 3 * 3 };
+
+			float error{};
+			std::vector<uint32_t> simplifiedIndices{ MeshOptimizer::SimplifyMesh(m_Vertices, m_Indices, targetIndexCount, &error) };
+
+			// Stop when the mesh can not be simplified any further
+			if (simplifiedIndices.empty() || simplifiedIndices.size() > lodIndices.back().size() * 3 / 4) break;
+
+			MeshOptimizer::OptimizeVertexCache(simplifiedIndices, m_Vertices.size());
+			MeshOptimizer::OptimizeOverdraw(simplifiedIndices, m_Vertices);
+			lodIndices.push_back(std::move(simplifiedIndices));
+			lodErrors.push_back(error);
+		}
+
+		// Store all LODs after each other in one index buffer
+		m_Indices.clear();
+		for (size_t lodIdx{}; lodIdx < lodIndices.size(); ++lodIdx)
+		{
+			MeshLod lod{};
+			lod.indexOffset = static_cast<uint32_t>(m_Indices.size());
+			lod.indexCount = static_cast<uint32_t>(lodIndices[lodIdx].size());
+			lod.error = lodErrors[lodIdx];
+			m_Lods.push_back(lod);
+
+			m_Indices.insert(m_Indices.end(), lodIndices[lodIdx].begin(), lodIndices[lodIdx].end());
+		}
+
+		// The vertices are then sorted in the order the new triangles use them, the full resolution LOD comes first
+		MeshOptimizer::OptimizeVertexFetch(m_Vertices, m_Indices);
+
+		const MeshLod& fullLod{ m_Lods.front() };
+		const std::vector<uint32_t> fullIndices{ m_Indices.begin(), m_Indices.begin() + fullLod.indexCount };
+		const MeshOptimizer::VertexCacheStatistics statisticsAfter{ MeshOptimizer::AnalyzeVertexCache(fullIndices, m_Vertices.size()) };
+
+		// Report the improvement
+		std::cout << filePath << ": " << m_Vertices.size() << " vertices, " << fullLod.indexCount / 3 << " triangles\n";
+		std::cout << "\tACMR " << statisticsBefore.acmr << " -> " << statisticsAfter.acmr
+			<< ", ATVR " << statisticsBefore.atvr << " -> " << statisticsAfter.atvr
+			<< " (FIFO cache of " << MeshOptimizer::VertexCacheSize << ")\n";
+		std::cout << "\tOverdraw " << overdrawBefore.overdraw << " -> " << overdrawAfter.overdraw << " (6 axis aligned views)\n";
+
+		// Split the optimized triangle order of every LOD into meshlets that can be culled as a whole
+		for (size_t lodIdx{}; lodIdx < m_Lods.size(); ++lodIdx)
+		{
+			MeshLod& lod{ m_Lods[lodIdx] };
+			const std::vector<uint32_t> lodIndexRange{ m_Indices.begin() + lod.indexOffset, m_Indices.begin() + lod.indexOffset + lod.indexCount };
+
+			std::vector<Meshlet> lodMeshlets{ MeshOptimizer::BuildMeshlets(m_Vertices, lodIndexRange) };
+			for (Meshlet& meshlet : lodMeshlets)
+			{
+				meshlet.indexOffset += lod.indexOffset;
+			}
+
+			lod.meshletOffset = static_cast<uint32_t>(m_Meshlets.size());
+			lod.meshletCount = static_cast<uint32_t>(lodMeshlets.size());
+			m_Meshlets.insert(m_Meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+
+			std::cout << "\tLOD " << lodIdx << ": " << lod.indexCount / 3 << " triangles, "
+				<< lod.meshletCount << " meshlets, error " << lod.error << "\n";
+		}
+	}
+
 	void Mesh::RotateY(float angle)
 	{
+		if (angle == 0.0f) return;
+
 		Matrix rotationMatrix{ Matrix::CreateRotationY(angle) };
 		m_WorldMatrix = rotationMatrix * m_WorldMatrix;
+		++m_WorldMatrixVersion;
 	}
 
 	void Mesh::SetPosition(const Vector3& position)
@@ -67,11 +217,117 @@ namespace dae
 		m_WorldMatrix[3][0] = position.x;
 		m_WorldMatrix[3][1] = position.y;
 		m_WorldMatrix[3][2] = position.z;
+		++m_WorldMatrixVersion;
+	}
+
+	void Mesh::SelectLod(const Vector3& cameraPosition, float pixelsPerUnit)
+	{
+		// The maximum amount of pixels the simplified surface may deviate on screen
+		constexpr float maxPixelError{ 1.0f };
+
+		// All instances share one LOD, so it is chosen for the closest visible instance
+		if (m_VisibleInstances.empty() || !IsLoaded()) return;
+
+		float worldScale{ 1.0f };
+		float distance{ FLT_MAX };
+		for (uint32_t instanceIdx : m_VisibleInstances)
+		{
+			const BoundingSphere worldSphere{ m_BoundingSphere.Transformed(GetInstanceWorldMatrix(instanceIdx)) };
+
+			// Project the errors at the closest point of the bounding sphere
+			const float instanceDistance{ (worldSphere.center - cameraPosition).Magnitude() - worldSphere.radius };
+			if (instanceDistance < distance)
+			{
+				distance = instanceDistance;
+				worldScale = m_BoundingSphere.radius > 0.0f ? worldSphere.radius / m_BoundingSphere.radius : 1.0f;
+			}
+		}
+
+		// Pick the coarsest LOD that still looks the same as the full resolution mesh
+		m_LodIdx = 0;
+		if (distance <= 0.0f) return;
+
+		for (uint32_t lodIdx{ static_cast<uint32_t>(m_Lods.size()) - 1 }; lodIdx > 0; --lodIdx)
+		{
+			const float projectedError{ m_Lods[lodIdx].error * worldScale * pixelsPerUnit / distance };
+			if (projectedError <= maxPixelError)
+			{
+				m_LodIdx = lodIdx;
+				break;
+			}
+		}
+	}
+
+	const MeshLod& Mesh::GetCurrentLod() const
+	{
+		return m_Lods[m_LodIdx];
+	}
+
+	void Mesh::SetInstances(ID3D11Device* pDevice, const std::vector<Matrix>& instanceMatrices)
+	{
+		m_InstanceMatrices = instanceMatrices;
+		m_VisibleInstances.clear();
+		++m_WorldMatrixVersion;
+
+		if (m_pInstanceBufferView) m_pInstanceBufferView->Release();
+		if (m_pInstanceBuffer) m_pInstanceBuffer->Release();
+		m_pInstanceBufferView = nullptr;
+		m_pInstanceBuffer = nullptr;
+
+		if (m_InstanceMatrices.empty()) return;
+
+		// Create a structured buffer that can hold the world matrix of every instance
+		D3D11_BUFFER_DESC bd{};
+		bd.Usage = D3D11_USAGE_DYNAMIC;
+		bd.ByteWidth = static_cast<uint32_t>(sizeof(Matrix) * m_InstanceMatrices.size());
+		bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bd.StructureByteStride = sizeof(Matrix);
+
+		HRESULT result{ pDevice->CreateBuffer(&bd, nullptr, &m_pInstanceBuffer) };
+		if (FAILED(result)) return;
+
+		// Create the view the vertex shader reads the matrices through
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = static_cast<uint32_t>(m_InstanceMatrices.size());
+
+		result = pDevice->CreateShaderResourceView(m_pInstanceBuffer, &srvDesc, &m_pInstanceBufferView);
+		if (FAILED(result)) return;
+	}
+
+	uint32_t Mesh::GetInstanceCount() const
+	{
+		return m_InstanceMatrices.empty() ? 1 : static_cast<uint32_t>(m_InstanceMatrices.size());
+	}
+
+	Matrix Mesh::GetInstanceWorldMatrix(uint32_t instanceIdx) const
+	{
+		return m_InstanceMatrices.empty() ? m_WorldMatrix : m_WorldMatrix * m_InstanceMatrices[instanceIdx];
+	}
+
+	const std::vector<uint32_t>& Mesh::GetVisibleInstances() const
+	{
+		return m_VisibleInstances;
+	}
+
+	void Mesh::ClearVisibleInstances()
+	{
+		m_VisibleInstances.clear();
+	}
+
+	void Mesh::AddVisibleInstance(uint32_t instanceIdx)
+	{
+		m_VisibleInstances.push_back(instanceIdx);
 	}
 
 	void Mesh::HardwareRender(ID3D11DeviceContext* pDeviceContext) const
 	{
-		if (!m_IsVisible) return;
+		// Streamed meshes have no vertex buffer
+		if (!m_IsVisible || !IsInFrustum() || !m_pVertexBuffer) return;
 
 		// Set primitive topology
 		pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -80,51 +336,176 @@ namespace dae
 		pDeviceContext->IASetInputLayout(m_pInputLayout);
 
 		// Set vertex buffer
-		constexpr UINT stride{ sizeof(Vertex) };
+		const UINT stride{ static_cast<UINT>(m_VertexFormat == VertexFormat::Quantized ? sizeof(VertexQuantized) : sizeof(Vertex)) };
 		constexpr UINT offset{ 0 };
 		pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 
 		// Set index buffer
-		pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, Uses16BitIndices() ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+
+		// Draw the index range of the current LOD
+		const MeshLod& lod{ GetCurrentLod() };
+		const uint32_t indexCount{ lod.indexCount };
+		const uint32_t indexOffset{ lod.indexOffset };
+
+		// Instanced meshes write the world matrices of their visible instances, the vertex shader picks them with the instance id
+		const bool isInstanced{ m_pInstanceBuffer != nullptr };
+		if (isInstanced)
+		{
+			D3D11_MAPPED_SUBRESOURCE mappedResource{};
+			if (FAILED(pDeviceContext->Map(m_pInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))) return;
+
+			Matrix* pInstanceWorldMatrices{ static_cast<Matrix*>(mappedResource.pData) };
+			for (size_t visibleIdx{}; visibleIdx < m_VisibleInstances.size(); ++visibleIdx)
+			{
+				pInstanceWorldMatrices[visibleIdx] = GetInstanceWorldMatrix(m_VisibleInstances[visibleIdx]);
+			}
+
+			pDeviceContext->Unmap(m_pInstanceBuffer, 0);
+			m_pMaterial->SetInstanceBuffer(m_pInstanceBufferView);
+		}
+
+		ID3DX11EffectTechnique* pTechnique{ m_pMaterial->GetTechnique(m_VertexFormat, isInstanced) };
 
-		// Draw
 		D3DX11_TECHNIQUE_DESC techniqueDesc{};
-		m_pMaterial->GetTechnique()->GetDesc(&techniqueDesc);
+		pTechnique->GetDesc(&techniqueDesc);
 		for (UINT p{}; p < techniqueDesc.Passes; ++p)
 		{
-			m_pMaterial->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-			pDeviceContext->DrawIndexed(static_cast<uint32_t>(m_Indices.size()), 0, 0);
+			pTechnique->GetPassByIndex(p)->Apply(0, pDeviceContext);
+			if (isInstanced) pDeviceContext->DrawIndexedInstanced(indexCount, static_cast<UINT>(m_VisibleInstances.size()), indexOffset, 0, 0);
+			else pDeviceContext->DrawIndexed(indexCount, indexOffset, 0);
 		}
 	}
 
-	Matrix& Mesh::GetWorldMatrix()
+	const Matrix& Mesh::GetWorldMatrix() const
 	{
 		return m_WorldMatrix;
 	}
 
+	uint32_t Mesh::GetWorldMatrixVersion() const
+	{
+		return m_WorldMatrixVersion;
+	}
+
 	std::vector<Vertex>& Mesh::GetVertices()
 	{
 		return m_Vertices;
 	}
 
+	const std::vector<VertexQuantized>& Mesh::GetQuantizedVertices() const
+	{
+		return m_QuantizedVertices;
+	}
+
+	size_t Mesh::GetVertexCount() const
+	{
+		return m_VertexFormat == VertexFormat::Quantized ? m_QuantizedVertices.size() : m_Vertices.size();
+	}
+
+	VertexFormat Mesh::GetVertexFormat() const
+	{
+		return m_VertexFormat;
+	}
+
+	const BoundingBox& Mesh::GetBoundingBox() const
+	{
+		return m_BoundingBox;
+	}
+
 	std::vector<uint32_t>& Mesh::GetIndices()
 	{
 		return m_Indices;
 	}
 
+	const std::vector<uint16_t>& Mesh::GetIndices16() const
+	{
+		return m_Indices16;
+	}
+
+	bool Mesh::Uses16BitIndices() const
+	{
+		return !m_Indices16.empty();
+	}
+
+	const std::vector<Meshlet>& Mesh::GetMeshlets() const
+	{
+		return m_Meshlets;
+	}
+
 	PrimitiveTopology Mesh::GetPrimitiveTopology() const
 	{
 		return m_PrimitiveTopology;
 	}
 
+	bool Mesh::IsStreamed() const
+	{
+		return m_pClusterStreamer != nullptr;
+	}
+
+	const ClusterStreamer* Mesh::GetClusterStreamer() const
+	{
+		return m_pClusterStreamer.get();
+	}
+
+	uint32_t Mesh::GetResidencyVersion() const
+	{
+		return m_pClusterStreamer ? m_pClusterStreamer->GetResidencyVersion() : 0;
+	}
+
+	void Mesh::StreamVisibleClusters(const Matrix& viewProjectionMatrix, const Vector3& cameraPosition)
+	{
+		if (!m_pClusterStreamer || !m_IsVisible) return;
+
+		for (uint32_t instanceIdx : m_VisibleInstances)
+		{
+			// Extracting the frustum from the world view projection matrix gives the planes in object space
+			const Matrix worldMatrix{ GetInstanceWorldMatrix(instanceIdx) };
+			const Frustum frustum{ Frustum::FromViewProjection(worldMatrix * viewProjectionMatrix) };
+			const Vector3 objectSpaceCameraPosition{ Matrix::Inverse(worldMatrix).TransformPoint(cameraPosition) };
+
+			// Request every cluster inside the frustum, the closest ones are loaded first
+			for (uint32_t clusterIdx{}; clusterIdx < m_pClusterStreamer->GetClusterCount(); ++clusterIdx)
+			{
+				const BoundingSphere& boundingSphere{ m_pClusterStreamer->GetCluster(clusterIdx).boundingSphere };
+				if (frustum.IsOutside(boundingSphere)) continue;
+
+				m_pClusterStreamer->RequestCluster(clusterIdx, (boundingSphere.center - objectSpaceCameraPosition).SqrMagnitude());
+			}
+		}
+
+		m_pClusterStreamer->LoadRequestedClusters();
+	}
+
 	bool Mesh::IsVisible() const
 	{
 		return m_IsVisible;
 	}
 
+	bool Mesh::IsLoaded() const
+	{
+		// A mesh whose OBJ could not be parsed has no LODs and no bounds
+		return !m_Lods.empty();
+	}
+
+	bool Mesh::IsInFrustum() const
+	{
+		return !m_VisibleInstances.empty();
+	}
+
+	bool Mesh::IsTransparent() const
+	{
+		return m_pMaterial->IsTransparent();
+	}
+
+	BoundingSphere Mesh::GetWorldBoundingSphere() const
+	{
+		return m_BoundingSphere.Transformed(m_WorldMatrix);
+	}
+
 	void Mesh::SetMatrices(const Matrix& viewProjectionMatrix, const Matrix& inverseViewMatrix)
 	{
 		m_pMaterial->SetMatrix(MatrixType::WorldViewProjection, m_WorldMatrix * viewProjectionMatrix);
+		m_pMaterial->SetMatrix(MatrixType::ViewProjection, viewProjectionMatrix);
 		m_pMaterial->SetMatrix(MatrixType::InverseView, inverseViewMatrix);
 		m_pMaterial->SetMatrix(MatrixType::World, m_WorldMatrix);
 	}
@@ -1,26 +1,60 @@
 #pragma once
 #include "DataTypes.h"
+#include "BoundingVolumes.h"
 
 namespace dae
 {
 	class Material;
+	class ClusterStreamer;
 
 	class Mesh final
 	{
 	public:
-		Mesh(ID3D11Device* pDevice, const std::string& filePath, Material* pMaterial, ID3D11SamplerState* pSampleState = nullptr);
+		Mesh(ID3D11Device* pDevice, const std::string& filePath, Material* pMaterial, ID3D11SamplerState* pSampleState = nullptr,
+			VertexFormat vertexFormat = VertexFormat::Full);
+		// Streams the clusters of the mesh from the cluster file under the memory budget (in bytes), the cluster file is written from the OBJ file first if it does not exist yet
+		// Streamed meshes are only rendered by the software rasterizer, throws std::runtime_error when the mesh cannot be streamed
+		Mesh(const std::string& filePath, const std::string& clusterFilePath, size_t memoryBudget, Material* pMaterial);
 		~Mesh();
 
 		// Shared
+		bool IsLoaded() const;
 		void RotateY(float angle);
 		void SetPosition(const Vector3& position);
-		Matrix& GetWorldMatrix();
+		const Matrix& GetWorldMatrix() const;
+		uint32_t GetWorldMatrixVersion() const;
+		bool IsInFrustum() const;
+		bool IsTransparent() const;
+		BoundingSphere GetWorldBoundingSphere() const;
+		void SelectLod(const Vector3& cameraPosition, float pixelsPerUnit);
+		const MeshLod& GetCurrentLod() const;
+
+		// Instancing, every instance matrix is applied after the world matrix of the mesh
+		void SetInstances(ID3D11Device* pDevice, const std::vector<Matrix>& instanceMatrices);
+		uint32_t GetInstanceCount() const;
+		Matrix GetInstanceWorldMatrix(uint32_t instanceIdx) const;
+		const std::vector<uint32_t>& GetVisibleInstances() const;
+		void ClearVisibleInstances();
+		void AddVisibleInstance(uint32_t instanceIdx);
 
 		// Software Rasterizer
 		std::vector<Vertex>& GetVertices();
+		const std::vector<VertexQuantized>& GetQuantizedVertices() const;
+		size_t GetVertexCount() const;
+		VertexFormat GetVertexFormat() const;
+		const BoundingBox& GetBoundingBox() const;
 		std::vector<uint32_t>& GetIndices();
+		const std::vector<uint16_t>& GetIndices16() const;
+		bool Uses16BitIndices() const;
+		const std::vector<Meshlet>& GetMeshlets() const;
 		PrimitiveTopology GetPrimitiveTopology() const;
 
+		// Streaming, only the clusters inside the frustum of a visible instance are kept resident
+		bool IsStreamed() const;
+		const ClusterStreamer* GetClusterStreamer() const;
+		uint32_t GetResidencyVersion() const;
+		void StreamVisibleClusters(const Matrix& viewProjectionMatrix, const Vector3& cameraPosition);
+
 		// DirectX Rasterizer
 		void SetMatrices(const Matrix& viewProjectionMatrix, const Matrix& inverseViewMatrix);
 		void SetSamplerState(ID3D11SamplerState* pSampleState);
@@ -31,11 +65,32 @@ namespace dae
 	private:
 		// Shared
 		Matrix m_WorldMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3::Zero };
+		// Increases every time the world matrix changes
+		uint32_t m_WorldMatrixVersion{};
+
+		// Object space bounds, calculated at load time
+		BoundingBox m_BoundingBox{};
+		BoundingSphere m_BoundingSphere{};
+
+		// Without instance matrices the mesh is drawn once with its world matrix
+		std::vector<Matrix> m_InstanceMatrices{};
+		// The instances that are (partially) inside the camera frustum, filled by the scene hierarchy
+		std::vector<uint32_t> m_VisibleInstances{ 0 };
 
 		// Software Rasterizer
+		// Only one of the vertex lists is filled, depending on the vertex format
 		std::vector<Vertex> m_Vertices{};
+		std::vector<VertexQuantized> m_QuantizedVertices{};
+		VertexFormat m_VertexFormat{ VertexFormat::Full };
+		// Only one of the index lists is filled, 16-bit indices are used when the vertex count allows it
 		std::vector<uint32_t> m_Indices{};
+		std::vector<uint16_t> m_Indices16{};
+		std::vector<Meshlet> m_Meshlets{};
+		std::vector<MeshLod> m_Lods{};
+		uint32_t m_LodIdx{};
 		PrimitiveTopology m_PrimitiveTopology{ PrimitiveTopology::TriangleList };
+		// Only set for streamed meshes, which have no vertices and indices of their own
+		std::unique_ptr<ClusterStreamer> m_pClusterStreamer{};
 
 		// DirectX Rasterizer
 		bool m_IsVisible{ true };
@@ -46,5 +101,11 @@ namespace dae
 
 		ID3D11Buffer* m_pVertexBuffer{};
 		ID3D11Buffer* m_pIndexBuffer{};
+
+		// The world matrices of the visible instances, rewritten every frame
+		ID3D11Buffer* m_pInstanceBuffer{};
+		ID3D11ShaderResourceView* m_pInstanceBufferView{};
+
+		void OptimizeMesh(const std::string& filePath);
 	};
 }
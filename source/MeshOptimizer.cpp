@@ -0,0 +1,938 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include <map>
+#include <queue>
+#include <tuple>
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			// For every vertex, the list of triangles that use it (stored as one flat array)
+			struct TriangleAdjacency
+			{
+				std::vector<uint32_t> counts{};
+				std::vector<uint32_t> offsets{};
+				std::vector<uint32_t> triangles{};
+			};
+
+			TriangleAdjacency BuildTriangleAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+			{
+				TriangleAdjacency adjacency{};
+				adjacency.counts.resize(vertexCount);
+				adjacency.offsets.resize(vertexCount);
+				adjacency.triangles.resize(indices.size());
+
+				// Count the amount of triangles every vertex is part of
+				for (uint32_t index : indices)
+				{
+					++adjacency.counts[index];
+				}
+
+				// Calculate where the triangle list of every vertex starts
+				uint32_t offset{};
+				for (size_t vertexIdx{}; vertexIdx < vertexCount; ++vertexIdx)
+				{
+					adjacency.offsets[vertexIdx] = offset;
+					offset += adjacency.counts[vertexIdx];
+				}
+
+				// Fill in the triangle lists
+				std::vector<uint32_t> fillOffsets{ adjacency.offsets };
+				for (size_t i{}; i < indices.size(); ++i)
+				{
+					adjacency.triangles[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+				}
+
+				return adjacency;
+			}
+
+			// Adds the vertices of a triangle to a simulated FIFO cache and returns how many of them had to be transformed
+			uint32_t SimulateTriangle(const uint32_t* pTriangle, std::vector<uint32_t>& cacheTimeStamps, uint32_t& timeStamp, uint32_t cacheSize)
+			{
+				uint32_t nrMisses{};
+				for (int corner{}; corner < 3; ++corner)
+				{
+					if (timeStamp - cacheTimeStamps[pTriangle[corner]] > cacheSize)
+					{
+						cacheTimeStamps[pTriangle[corner]] = timeStamp++;
+						++nrMisses;
+					}
+				}
+				return nrMisses;
+			}
+
+			int16_t EncodeSnorm16(float value)
+			{
+				return static_cast<int16_t>(roundf(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+			}
+
+			float DecodeSnorm16(int16_t value)
+			{
+				return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+			}
+
+			// Projects a unit vector onto an octahedron that is unfolded into the [-1, 1] square [Cigolle et al. 2014]
+			void EncodeOctahedral(const Vector3& vector, int16_t result[2])
+			{
+				const float length{ abs(vector.x) + abs(vector.y) + abs(vector.z) };
+				if (length < FLT_EPSILON)
+				{
+					result[0] = result[1] = 0;
+					return;
+				}
+
+				float x{ vector.x / length };
+				float y{ vector.y / length };
+
+				// Fold the lower hemisphere over the diagonals
+				if (vector.z < 0.0f)
+				{
+					const float foldedX{ (1.0f - abs(y)) * (x >= 0.0f ? 1.0f : -1.0f) };
+					const float foldedY{ (1.0f - abs(x)) * (y >= 0.0f ? 1.0f : -1.0f) };
+					x = foldedX;
+					y = foldedY;
+				}
+
+				result[0] = EncodeSnorm16(x);
+				result[1] = EncodeSnorm16(y);
+			}
+
+			Vector3 DecodeOctahedral(const int16_t encoded[2])
+			{
+				Vector3 result{ DecodeSnorm16(encoded[0]), DecodeSnorm16(encoded[1]), 0.0f };
+				result.z = 1.0f - abs(result.x) - abs(result.y);
+
+				// Unfold the lower hemisphere
+				const float t{ std::max(-result.z, 0.0f) };
+				result.x += result.x >= 0.0f ? -t : t;
+				result.y += result.y >= 0.0f ? -t : t;
+
+				return result.Normalized();
+			}
+
+			uint16_t EncodeHalf(float value)
+			{
+				uint32_t bits{};
+				memcpy(&bits, &value, sizeof(bits));
+
+				const uint32_t sign{ (bits >> 16) & 0x8000 };
+				const int exponent{ static_cast<int>((bits >> 23) & 0xFF) - 127 + 15 };
+				const uint32_t mantissa{ bits & 0x007FFFFF };
+
+				// Too small to represent, flush to zero
+				if (exponent <= 0) return static_cast<uint16_t>(sign);
+
+				// Too large, clamp to infinity
+				if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7C00);
+
+				// Round the mantissa to the nearest value
+				return static_cast<uint16_t>((sign | (exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1));
+			}
+
+			float DecodeHalf(uint16_t value)
+			{
+				const uint32_t sign{ static_cast<uint32_t>(value & 0x8000) << 16 };
+				const uint32_t exponent{ static_cast<uint32_t>((value >> 10) & 0x1F) };
+				const uint32_t mantissa{ value & 0x03FFu };
+
+				uint32_t bits{ sign };
+				if (exponent == 31) bits |= 0x7F800000 | (mantissa << 13);
+				else if (exponent != 0) bits |= ((exponent - 15 + 127) << 23) | (mantissa << 13);
+				else if (mantissa != 0)
+				{
+					// Denormal half, store it as a normal float
+					const float denormal{ static_cast<float>(mantissa) / 1024.0f / 16384.0f };
+					return sign ? -denormal : denormal;
+				}
+
+				float result{};
+				memcpy(&result, &bits, sizeof(result));
+				return result;
+			}
+
+			// Symmetric 4x4 matrix that sums the squared distances to a set of planes
+			struct Quadric
+			{
+				double a00{}, a01{}, a02{}, a03{};
+				double a11{}, a12{}, a13{};
+				double a22{}, a23{};
+				double a33{};
+
+				static Quadric FromPlane(const Vector3& normal, float distance)
+				{
+					const double x{ normal.x }, y{ normal.y }, z{ normal.z }, d{ distance };
+					return Quadric{ x * x, x * y, x * z, x * d, y * y, y * z, y * d, z * z, z * d, d * d };
+				}
+
+				Quadric& operator+=(const Quadric& q)
+				{
+					a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+					a11 += q.a11; a12 += q.a12; a13 += q.a13;
+					a22 += q.a22; a23 += q.a23;
+					a33 += q.a33;
+					return *this;
+				}
+
+				double Evaluate(const Vector3& point) const
+				{
+					const double x{ point.x }, y{ point.y }, z{ point.z };
+					return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+						+ a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+						+ a22 * z * z + 2.0 * a23 * z
+						+ a33;
+				}
+			};
+
+			struct Collapse
+			{
+				double cost{};
+				uint32_t fromVertex{};
+				uint32_t toVertex{};
+				uint32_t version{};
+
+				// Used to turn the priority queue into a min heap
+				bool operator>(const Collapse& other) const
+				{
+					return cost > other.cost;
+				}
+			};
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			// Tipsify [Sander et al. 2007]: fan around a vertex and pick the next fanning vertex that is still in the cache
+			const size_t nrTriangles{ indices.size() / 3 };
+			if (nrTriangles == 0 || vertexCount == 0) return;
+
+			const TriangleAdjacency adjacency{ BuildTriangleAdjacency(indices, vertexCount) };
+
+			// The amount of triangles that still have to be emitted for every vertex
+			std::vector<uint32_t> liveTriangles{ adjacency.counts };
+
+			// The time at which each vertex entered the simulated cache
+			std::vector<uint32_t> cacheTimeStamps(vertexCount);
+
+			std::vector<bool> isEmitted(nrTriangles);
+			std::vector<uint32_t> deadEndStack{};
+			std::vector<uint32_t> candidates{};
+
+			std::vector<uint32_t> newIndices{};
+			newIndices.reserve(indices.size());
+
+			uint32_t timeStamp{ cacheSize + 1 };
+			uint32_t cursor{};
+
+			// Start fanning around the first vertex
+			int64_t fanningVertex{ indices[0] };
+
+			while (fanningVertex >= 0)
+			{
+				candidates.clear();
+
+				const uint32_t vertexIdx{ static_cast<uint32_t>(fanningVertex) };
+				const uint32_t* pAdjacentBegin{ adjacency.triangles.data() + adjacency.offsets[vertexIdx] };
+				const uint32_t* pAdjacentEnd{ pAdjacentBegin + adjacency.counts[vertexIdx] };
+
+				// Emit all the triangles around the fanning vertex that have not been emitted yet
+				for (const uint32_t* pTriangle{ pAdjacentBegin }; pTriangle != pAdjacentEnd; ++pTriangle)
+				{
+					const uint32_t triangleIdx{ *pTriangle };
+					if (isEmitted[triangleIdx]) continue;
+
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t index{ indices[triangleIdx * 3 + corner] };
+
+						newIndices.push_back(index);
+						deadEndStack.push_back(index);
+						candidates.push_back(index);
+
+						--liveTriangles[index];
+
+						// If the vertex is not in the cache anymore, it gets transformed and enters the cache again
+						if (timeStamp - cacheTimeStamps[index] > cacheSize)
+						{
+							cacheTimeStamps[index] = timeStamp++;
+						}
+					}
+
+					isEmitted[triangleIdx] = true;
+				}
+
+				// Pick the candidate with live triangles that entered the cache the longest ago, but will still be in the cache after fanning around it
+				fanningVertex = -1;
+				uint32_t bestPriority{};
+				for (uint32_t candidate : candidates)
+				{
+					if (liveTriangles[candidate] == 0) continue;
+
+					uint32_t priority{};
+					if (timeStamp - cacheTimeStamps[candidate] + 2 * liveTriangles[candidate] <= cacheSize)
+					{
+						priority = timeStamp - cacheTimeStamps[candidate];
+					}
+
+					if (fanningVertex < 0 || priority > bestPriority)
+					{
+						fanningVertex = candidate;
+						bestPriority = priority;
+					}
+				}
+
+				if (fanningVertex >= 0) continue;
+
+				// Dead end: try the most recently used vertices first
+				while (!deadEndStack.empty())
+				{
+					const uint32_t deadEndVertex{ deadEndStack.back() };
+					deadEndStack.pop_back();
+
+					if (liveTriangles[deadEndVertex] > 0)
+					{
+						fanningVertex = deadEndVertex;
+						break;
+					}
+				}
+
+				// Otherwise continue with the next vertex in input order that still has triangles
+				while (fanningVertex < 0 && cursor < vertexCount)
+				{
+					if (liveTriangles[cursor] > 0) fanningVertex = cursor;
+					++cursor;
+				}
+			}
+
+			indices.swap(newIndices);
+		}
+
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold, uint32_t cacheSize)
+		{
+			const uint32_t triangleCount{ static_cast<uint32_t>(indices.size() / 3) };
+			if (triangleCount == 0) return;
+
+			std::vector<uint32_t> cacheTimeStamps(vertices.size());
+			uint32_t timeStamp{ cacheSize + 1 };
+
+			// Flushing the cache makes every vertex a miss again
+			auto flushCache = [&]() { timeStamp += cacheSize + 1; };
+
+			// Hard boundaries: triangles of which no vertex was in the cache, this is where the vertex cache order jumped to another area
+			std::vector<uint32_t> hardBoundaries{};
+			for (uint32_t triangleIdx{}; triangleIdx < triangleCount; ++triangleIdx)
+			{
+				const uint32_t nrMisses{ SimulateTriangle(&indices[triangleIdx * 3], cacheTimeStamps, timeStamp, cacheSize) };
+				if (triangleIdx == 0 || nrMisses == 3) hardBoundaries.push_back(triangleIdx);
+			}
+			hardBoundaries.push_back(triangleCount);
+
+			// Soft boundaries: split the hard clusters further as soon as the cache efficiency is close enough to the one of the whole cluster
+			std::vector<uint32_t> clusterStarts{};
+			for (size_t hardClusterIdx{}; hardClusterIdx + 1 < hardBoundaries.size(); ++hardClusterIdx)
+			{
+				const uint32_t begin{ hardBoundaries[hardClusterIdx] };
+				const uint32_t end{ hardBoundaries[hardClusterIdx + 1] };
+
+				flushCache();
+				uint32_t clusterMisses{};
+				for (uint32_t triangleIdx{ begin }; triangleIdx < end; ++triangleIdx)
+				{
+					clusterMisses += SimulateTriangle(&indices[triangleIdx * 3], cacheTimeStamps, timeStamp, cacheSize);
+				}
+				const float clusterThreshold{ threshold * clusterMisses / (end - begin) };
+
+				flushCache();
+				clusterStarts.push_back(begin);
+
+				uint32_t start{ begin };
+				uint32_t nrMisses{};
+				for (uint32_t triangleIdx{ begin }; triangleIdx < end; ++triangleIdx)
+				{
+					nrMisses += SimulateTriangle(&indices[triangleIdx * 3], cacheTimeStamps, timeStamp, cacheSize);
+
+					if (triangleIdx + 1 < end && nrMisses <= clusterThreshold * (triangleIdx + 1 - start))
+					{
+						start = triangleIdx + 1;
+						nrMisses = 0;
+						clusterStarts.push_back(start);
+						flushCache();
+					}
+				}
+			}
+			clusterStarts.push_back(triangleCount);
+
+			const size_t clusterCount{ clusterStarts.size() - 1 };
+
+			// The area weighted centroid and normal of every cluster, and of the whole mesh
+			std::vector<Vector3> clusterCentroids(clusterCount);
+			std::vector<Vector3> clusterNormals(clusterCount);
+			Vector3 meshCentroid{};
+			float meshArea{};
+
+			for (size_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+			{
+				float clusterArea{};
+				for (uint32_t triangleIdx{ clusterStarts[clusterIdx] }; triangleIdx < clusterStarts[clusterIdx + 1]; ++triangleIdx)
+				{
+					const Vector3& p0{ vertices[indices[triangleIdx * 3]].position };
+					const Vector3& p1{ vertices[indices[triangleIdx * 3 + 1]].position };
+					const Vector3& p2{ vertices[indices[triangleIdx * 3 + 2]].position };
+
+					// The length of the cross product is twice the area of the triangle
+					const Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+					const float area{ normal.Magnitude() };
+					const Vector3 centroid{ (p0 + p1 + p2) / 3.0f };
+
+					clusterCentroids[clusterIdx] += centroid * area;
+					clusterNormals[clusterIdx] += normal;
+					clusterArea += area;
+				}
+
+				meshCentroid += clusterCentroids[clusterIdx];
+				meshArea += clusterArea;
+
+				if (clusterArea > 0.0f) clusterCentroids[clusterIdx] /= clusterArea;
+			}
+
+			if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+			// Clusters that are far from the center and face away from it are the most likely to occlude other clusters
+			std::vector<float> clusterSortKeys(clusterCount);
+			for (size_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+			{
+				const float normalLength{ clusterNormals[clusterIdx].Magnitude() };
+				const Vector3 clusterNormal{ normalLength > 0.0f ? clusterNormals[clusterIdx] / normalLength : Vector3{} };
+				clusterSortKeys[clusterIdx] = Vector3::Dot(clusterCentroids[clusterIdx] - meshCentroid, clusterNormal);
+			}
+
+			std::vector<uint32_t> clusterOrder(clusterCount);
+			for (uint32_t clusterIdx{}; clusterIdx < clusterCount; ++clusterIdx)
+			{
+				clusterOrder[clusterIdx] = clusterIdx;
+			}
+			std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+				[&](uint32_t a, uint32_t b) { return clusterSortKeys[a] > clusterSortKeys[b]; });
+
+			// Emit the clusters in the sorted order
+			std::vector<uint32_t> newIndices{};
+			newIndices.reserve(indices.size());
+			for (uint32_t clusterIdx : clusterOrder)
+			{
+				newIndices.insert(newIndices.end(), indices.begin() + clusterStarts[clusterIdx] * 3, indices.begin() + clusterStarts[clusterIdx + 1] * 3);
+			}
+
+			indices = std::move(newIndices);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			constexpr uint32_t unusedIdx{ UINT32_MAX };
+
+			std::vector<uint32_t> remap(vertices.size(), unusedIdx);
+
+			std::vector<Vertex> newVertices{};
+			newVertices.reserve(vertices.size());
+
+			// Give every vertex a new index in the order it is first used in, unused vertices are dropped
+			for (uint32_t& index : indices)
+			{
+				if (remap[index] == unusedIdx)
+				{
+					remap[index] = static_cast<uint32_t>(newVertices.size());
+					newVertices.push_back(vertices[index]);
+				}
+
+				index = remap[index];
+			}
+
+			vertices.swap(newVertices);
+		}
+
+		std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float* pResultError)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			if (pResultError) *pResultError = 0.0f;
+
+			// Vertices that share a position (UV seams) belong to the same group
+			std::vector<uint32_t> positionGroups(vertices.size());
+			std::vector<uint32_t> groupSizes{};
+			std::map<std::tuple<float, float, float>, uint32_t> groupLookup{};
+			for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				const Vector3& position{ vertices[vertexIdx].position };
+				const auto insertResult{ groupLookup.emplace(std::make_tuple(position.x, position.y, position.z), static_cast<uint32_t>(groupSizes.size())) };
+				if (insertResult.second) groupSizes.push_back(0);
+
+				positionGroups[vertexIdx] = insertResult.first->second;
+				++groupSizes[positionGroups[vertexIdx]];
+			}
+
+			// Count how many triangles use every edge between two position groups
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeUsage{};
+			for (size_t firstIdx{}; firstIdx + 2 < indices.size(); firstIdx += 3)
+			{
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t groupA{ positionGroups[indices[firstIdx + corner]] };
+					const uint32_t groupB{ positionGroups[indices[firstIdx + (corner + 1) % 3]] };
+					++edgeUsage[std::minmax(groupA, groupB)];
+				}
+			}
+
+			// Seam vertices and vertices on open or non-manifold edges can not move without tearing the mesh
+			std::vector<bool> isGroupLocked(groupSizes.size());
+			for (size_t groupIdx{}; groupIdx < groupSizes.size(); ++groupIdx)
+			{
+				isGroupLocked[groupIdx] = groupSizes[groupIdx] > 1;
+			}
+			for (const auto& [edge, usage] : edgeUsage)
+			{
+				if (usage == 2) continue;
+
+				isGroupLocked[edge.first] = true;
+				isGroupLocked[edge.second] = true;
+			}
+
+			// Accumulate the planes of all the triangles around every position
+			std::vector<Quadric> groupQuadrics(groupSizes.size());
+			std::vector<uint32_t> triangles{ indices };
+			std::vector<std::vector<uint32_t>> vertexTriangles(vertices.size());
+			for (uint32_t triangleIdx{}; triangleIdx < nrTriangles; ++triangleIdx)
+			{
+				const Vector3& p0{ vertices[triangles[triangleIdx * 3]].position };
+				const Vector3& p1{ vertices[triangles[triangleIdx * 3 + 1]].position };
+				const Vector3& p2{ vertices[triangles[triangleIdx * 3 + 2]].position };
+
+				Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+				if (normal.Magnitude() > FLT_EPSILON)
+				{
+					normal.Normalize();
+
+					const Quadric planeQuadric{ Quadric::FromPlane(normal, -Vector3::Dot(normal, p0)) };
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						groupQuadrics[positionGroups[triangles[triangleIdx * 3 + corner]]] += planeQuadric;
+					}
+				}
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					vertexTriangles[triangles[triangleIdx * 3 + corner]].push_back(triangleIdx);
+				}
+			}
+
+			std::vector<bool> isTriangleRemoved(nrTriangles);
+			std::vector<uint32_t> vertexVersions(vertices.size());
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses{};
+
+			// Finds the cheapest neighbour a vertex can be collapsed onto and queues that collapse
+			auto queueCheapestCollapse = [&](uint32_t vertexIdx)
+				{
+					if (isGroupLocked[positionGroups[vertexIdx]]) return;
+
+					const Quadric& quadric{ groupQuadrics[positionGroups[vertexIdx]] };
+
+					Collapse cheapest{ DBL_MAX, vertexIdx, vertexIdx, vertexVersions[vertexIdx] };
+					for (uint32_t triangleIdx : vertexTriangles[vertexIdx])
+					{
+						if (isTriangleRemoved[triangleIdx]) continue;
+
+						for (uint32_t corner{}; corner < 3; ++corner)
+						{
+							const uint32_t neighbourIdx{ triangles[triangleIdx * 3 + corner] };
+							if (neighbourIdx == vertexIdx) continue;
+
+							const double cost{ quadric.Evaluate(vertices[neighbourIdx].position) };
+							if (cost < cheapest.cost)
+							{
+								cheapest.cost = cost;
+								cheapest.toVertex = neighbourIdx;
+							}
+						}
+					}
+
+					if (cheapest.toVertex != vertexIdx) collapses.push(cheapest);
+				};
+
+			// Moving a vertex onto its neighbour must not flip any of the triangles that stay
+			auto isCollapseValid = [&](const Collapse& collapse)
+				{
+					const Vector3& newPosition{ vertices[collapse.toVertex].position };
+					const uint32_t toGroup{ positionGroups[collapse.toVertex] };
+
+					for (uint32_t triangleIdx : vertexTriangles[collapse.fromVertex])
+					{
+						if (isTriangleRemoved[triangleIdx]) continue;
+
+						Vector3 oldCorners[3]{};
+						Vector3 newCorners[3]{};
+						bool isRemoved{};
+						for (uint32_t corner{}; corner < 3; ++corner)
+						{
+							const uint32_t vertexIdx{ triangles[triangleIdx * 3 + corner] };
+							isRemoved |= vertexIdx != collapse.fromVertex && positionGroups[vertexIdx] == toGroup;
+
+							oldCorners[corner] = vertices[vertexIdx].position;
+							newCorners[corner] = vertexIdx == collapse.fromVertex ? newPosition : oldCorners[corner];
+						}
+						if (isRemoved) continue;
+
+						const Vector3 oldNormal{ Vector3::Cross(oldCorners[1] - oldCorners[0], oldCorners[2] - oldCorners[0]) };
+						const Vector3 newNormal{ Vector3::Cross(newCorners[1] - newCorners[0], newCorners[2] - newCorners[0]) };
+						if (Vector3::Dot(oldNormal, newNormal) <= 0.0f) return false;
+					}
+
+					return true;
+				};
+
+			for (uint32_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				queueCheapestCollapse(vertexIdx);
+			}
+
+			size_t nrLiveTriangles{ nrTriangles };
+			double maxCost{};
+			std::vector<uint32_t> changedVertices{};
+
+			while (nrLiveTriangles * 3 > targetIndexCount && !collapses.empty())
+			{
+				const Collapse collapse{ collapses.top() };
+				collapses.pop();
+
+				// Skip collapses of vertices that changed since they were queued
+				if (collapse.version != vertexVersions[collapse.fromVertex]) continue;
+				if (!isCollapseValid(collapse)) continue;
+
+				const uint32_t toGroup{ positionGroups[collapse.toVertex] };
+				changedVertices.clear();
+
+				// Move all triangles to the new vertex, or remove them if they become degenerate
+				for (uint32_t triangleIdx : vertexTriangles[collapse.fromVertex])
+				{
+					if (isTriangleRemoved[triangleIdx]) continue;
+
+					bool isRemoved{};
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						uint32_t& vertexIdx{ triangles[triangleIdx * 3 + corner] };
+						if (vertexIdx == collapse.fromVertex)
+						{
+							vertexIdx = collapse.toVertex;
+							continue;
+						}
+
+						isRemoved |= positionGroups[vertexIdx] == toGroup;
+						changedVertices.push_back(vertexIdx);
+					}
+
+					if (isRemoved)
+					{
+						isTriangleRemoved[triangleIdx] = true;
+						--nrLiveTriangles;
+					}
+					else
+					{
+						vertexTriangles[collapse.toVertex].push_back(triangleIdx);
+					}
+				}
+
+				vertexTriangles[collapse.fromVertex].clear();
+				++vertexVersions[collapse.fromVertex];
+				groupQuadrics[toGroup] += groupQuadrics[positionGroups[collapse.fromVertex]];
+				maxCost = std::max(maxCost, collapse.cost);
+
+				// The neighbourhood of these vertices changed, so their cheapest collapse has to be found again
+				changedVertices.push_back(collapse.toVertex);
+				for (uint32_t vertexIdx : changedVertices)
+				{
+					++vertexVersions[vertexIdx];
+					queueCheapestCollapse(vertexIdx);
+				}
+			}
+
+			std::vector<uint32_t> result{};
+			result.reserve(nrLiveTriangles * 3);
+			for (uint32_t triangleIdx{}; triangleIdx < nrTriangles; ++triangleIdx)
+			{
+				if (isTriangleRemoved[triangleIdx]) continue;
+
+				result.insert(result.end(), triangles.begin() + triangleIdx * 3, triangles.begin() + triangleIdx * 3 + 3);
+			}
+
+			if (pResultError) *pResultError = static_cast<float>(sqrt(maxCost));
+
+			return result;
+		}
+
+		std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t maxVertices, uint32_t maxTriangles)
+		{
+			std::vector<Meshlet> meshlets{};
+
+			// The meshlet every vertex was last added to, used to count the unique vertices of the current meshlet
+			constexpr uint32_t noMeshletIdx{ UINT32_MAX };
+			std::vector<uint32_t> vertexMeshlet(vertices.size(), noMeshletIdx);
+			std::vector<uint32_t> meshletVertices{};
+
+			// Calculates the bounds and the normal cone of a finished meshlet
+			auto finishMeshlet = [&](Meshlet& meshlet)
+				{
+					BoundingBox boundingBox{};
+					for (uint32_t vertexIdx : meshletVertices)
+					{
+						boundingBox.Grow(vertices[vertexIdx].position);
+					}
+
+					meshlet.boundingSphere.center = boundingBox.GetCenter();
+					for (uint32_t vertexIdx : meshletVertices)
+					{
+						const float distance{ (vertices[vertexIdx].position - meshlet.boundingSphere.center).Magnitude() };
+						meshlet.boundingSphere.radius = std::max(meshlet.boundingSphere.radius, distance);
+					}
+
+					// The normals of the front facing side of the triangles
+					std::vector<Vector3> triangleNormals{};
+					triangleNormals.reserve(meshlet.triangleCount);
+
+					Vector3 averageNormal{};
+					for (uint32_t triangleIdx{}; triangleIdx < meshlet.triangleCount; ++triangleIdx)
+					{
+						const uint32_t firstIdx{ meshlet.indexOffset + triangleIdx * 3 };
+						const Vector3& p0{ vertices[indices[firstIdx]].position };
+						const Vector3& p1{ vertices[indices[firstIdx + 1]].position };
+						const Vector3& p2{ vertices[indices[firstIdx + 2]].position };
+
+						Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+						const float area{ normal.Magnitude() };
+						if (area < FLT_EPSILON) continue;
+
+						normal /= area;
+						triangleNormals.push_back(normal);
+						averageNormal += normal;
+					}
+
+					meshlet.coneAxis = Vector3::UnitZ;
+					meshlet.coneCutoff = 1.0f;
+
+					const float averageLength{ averageNormal.Magnitude() };
+					if (averageLength < FLT_EPSILON) return;
+
+					meshlet.coneAxis = averageNormal / averageLength;
+
+					// Find the triangle normal that is furthest away from the axis
+					float minDot{ 1.0f };
+					for (const Vector3& normal : triangleNormals)
+					{
+						minDot = std::min(minDot, Vector3::Dot(normal, meshlet.coneAxis));
+					}
+
+					// Cones that are (close to) a half sphere can never be culled
+					if (minDot > 0.1f)
+					{
+						meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+					}
+				};
+
+			Meshlet currentMeshlet{};
+			uint32_t meshletIdx{};
+			for (uint32_t firstIdx{}; firstIdx + 2 < indices.size(); firstIdx += 3)
+			{
+				// Count how many new vertices this triangle would add to the meshlet
+				uint32_t nrNewVertices{};
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					if (vertexMeshlet[indices[firstIdx + corner]] != meshletIdx) ++nrNewVertices;
+				}
+
+				// Start a new meshlet if the triangle does not fit anymore
+				if (meshletVertices.size() + nrNewVertices > maxVertices || currentMeshlet.triangleCount == maxTriangles)
+				{
+					finishMeshlet(currentMeshlet);
+					meshlets.push_back(currentMeshlet);
+
+					currentMeshlet = Meshlet{};
+					currentMeshlet.indexOffset = firstIdx;
+					meshletVertices.clear();
+					++meshletIdx;
+				}
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t vertexIdx{ indices[firstIdx + corner] };
+					if (vertexMeshlet[vertexIdx] == meshletIdx) continue;
+
+					vertexMeshlet[vertexIdx] = meshletIdx;
+					meshletVertices.push_back(vertexIdx);
+				}
+
+				++currentMeshlet.triangleCount;
+			}
+
+			if (currentMeshlet.triangleCount > 0)
+			{
+				finishMeshlet(currentMeshlet);
+				meshlets.push_back(currentMeshlet);
+			}
+
+			return meshlets;
+		}
+
+		std::vector<VertexQuantized> QuantizeVertices(const std::vector<Vertex>& vertices, const BoundingBox& boundingBox)
+		{
+			const Vector3 extents{ boundingBox.max - boundingBox.min };
+
+			std::vector<VertexQuantized> result(vertices.size());
+			for (size_t vertexIdx{}; vertexIdx < vertices.size(); ++vertexIdx)
+			{
+				const Vertex& vertex{ vertices[vertexIdx] };
+				VertexQuantized& quantized{ result[vertexIdx] };
+
+				for (int axis{}; axis < 3; ++axis)
+				{
+					// Flat boxes have no extent on an axis, all vertices are then at the minimum
+					const float normalized{ extents[axis] > 0.0f ? (vertex.position[axis] - boundingBox.min[axis]) / extents[axis] : 0.0f };
+					quantized.position[axis] = static_cast<uint16_t>(roundf(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+				}
+
+				EncodeOctahedral(vertex.normal, quantized.normal);
+				EncodeOctahedral(vertex.tangent, quantized.tangent);
+
+				quantized.uv[0] = EncodeHalf(vertex.uv.x);
+				quantized.uv[1] = EncodeHalf(vertex.uv.y);
+			}
+
+			return result;
+		}
+
+		Vertex DequantizeVertex(const VertexQuantized& vertex, const Vector3& positionScale, const Vector3& positionOffset)
+		{
+			Vertex result{};
+			result.position = Vector3
+			{
+				vertex.position[0] / 65535.0f * positionScale.x + positionOffset.x,
+				vertex.position[1] / 65535.0f * positionScale.y + positionOffset.y,
+				vertex.position[2] / 65535.0f * positionScale.z + positionOffset.z
+			};
+			result.normal = DecodeOctahedral(vertex.normal);
+			result.tangent = DecodeOctahedral(vertex.tangent);
+			result.uv = Vector2{ DecodeHalf(vertex.uv[0]), DecodeHalf(vertex.uv[1]) };
+
+			return result;
+		}
+
+		OverdrawStatistics AnalyzeOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			OverdrawStatistics statistics{};
+			if (indices.empty() || vertices.empty()) return statistics;
+
+			constexpr int gridSize{ 256 };
+			std::vector<float> depthBuffer(gridSize * gridSize);
+
+			// Scale the mesh uniformly into the grid
+			const BoundingBox boundingBox{ BoundingBox::FromVertices(vertices) };
+			const Vector3 extents{ boundingBox.max - boundingBox.min };
+			const float maxExtent{ std::max(extents.x, std::max(extents.y, extents.z)) };
+			if (maxExtent <= 0.0f) return statistics;
+
+			uint64_t nrCoveredPixels{};
+			uint64_t nrShadedPixels{};
+
+			// Look along every axis from both sides
+			for (int axis{}; axis < 3; ++axis)
+			{
+				for (int side{}; side < 2; ++side)
+				{
+					std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+					for (size_t i{}; i + 2 < indices.size(); i += 3)
+					{
+						// Project the triangle onto the other two axes, the depth is the distance along the view axis
+						Vector2 rasterPoints[3]{};
+						float depths[3]{};
+						for (int corner{}; corner < 3; ++corner)
+						{
+							const Vector3 position{ (vertices[indices[i + corner]].position - boundingBox.min) / maxExtent };
+							rasterPoints[corner] = Vector2{ position[(axis + 1) % 3], position[(axis + 2) % 3] } * static_cast<float>(gridSize);
+							depths[corner] = side == 0 ? position[axis] : -position[axis];
+						}
+
+						// The signed area is the component of the triangle normal along the view axis, front faces point to the viewer
+						const float area{ Vector2::Cross(rasterPoints[1] - rasterPoints[0], rasterPoints[2] - rasterPoints[0]) };
+						if (side == 0 ? area >= 0.0f : area <= 0.0f) continue;
+
+						const float sign{ area > 0.0f ? 1.0f : -1.0f };
+						const Vector2 minPoint{ Vector2::Min(rasterPoints[0], Vector2::Min(rasterPoints[1], rasterPoints[2])) };
+						const Vector2 maxPoint{ Vector2::Max(rasterPoints[0], Vector2::Max(rasterPoints[1], rasterPoints[2])) };
+
+						const int startX{ std::max(static_cast<int>(minPoint.x), 0) };
+						const int startY{ std::max(static_cast<int>(minPoint.y), 0) };
+						const int endX{ std::min(static_cast<int>(maxPoint.x) + 1, gridSize) };
+						const int endY{ std::min(static_cast<int>(maxPoint.y) + 1, gridSize) };
+
+						for (int py{ startY }; py < endY; ++py)
+						{
+							for (int px{ startX }; px < endX; ++px)
+							{
+								const Vector2 pixelCenter{ px + 0.5f, py + 0.5f };
+
+								const float weight0{ sign * Vector2::Cross(rasterPoints[2] - rasterPoints[1], pixelCenter - rasterPoints[1]) };
+								const float weight1{ sign * Vector2::Cross(rasterPoints[0] - rasterPoints[2], pixelCenter - rasterPoints[2]) };
+								const float weight2{ sign * Vector2::Cross(rasterPoints[1] - rasterPoints[0], pixelCenter - rasterPoints[0]) };
+								if (weight0 < 0.0f || weight1 < 0.0f || weight2 < 0.0f) continue;
+
+								// Same depth test as the software rasterizer
+								const float depth{ (weight0 * depths[0] + weight1 * depths[1] + weight2 * depths[2]) / (sign * area) };
+								float& bufferDepth{ depthBuffer[px + py * gridSize] };
+								if (bufferDepth < depth) continue;
+
+								bufferDepth = depth;
+								++nrShadedPixels;
+							}
+						}
+					}
+
+					nrCoveredPixels += std::count_if(depthBuffer.begin(), depthBuffer.end(), [](float depth) { return depth != FLT_MAX; });
+				}
+			}
+
+			statistics.overdraw = nrCoveredPixels > 0 ? static_cast<float>(nrShadedPixels) / nrCoveredPixels : 0.0f;
+
+			return statistics;
+		}
+
+		VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			VertexCacheStatistics statistics{};
+			if (indices.empty() || vertexCount == 0) return statistics;
+
+			// Simulate a FIFO cache: a vertex is still in the cache if less than cacheSize misses happened since it was added
+			std::vector<uint32_t> cacheTimeStamps(vertexCount);
+			uint32_t timeStamp{ cacheSize + 1 };
+			uint32_t nrTransformed{};
+
+			std::vector<bool> isUsed(vertexCount);
+			uint32_t nrUsedVertices{};
+
+			for (uint32_t index : indices)
+			{
+				if (timeStamp - cacheTimeStamps[index] > cacheSize)
+				{
+					cacheTimeStamps[index] = timeStamp++;
+					++nrTransformed;
+				}
+
+				if (!isUsed[index])
+				{
+					isUsed[index] = true;
+					++nrUsedVertices;
+				}
+			}
+
+			statistics.acmr = static_cast<float>(nrTransformed) / (indices.size() / 3);
+			statistics.atvr = static_cast<float>(nrTransformed) / nrUsedVertices;
+
+			return statistics;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "DataTypes.h"
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		struct VertexCacheStatistics
+		{
+			// Average Cache Miss Ratio: transformed vertices per triangle (0.5 is optimal, 3.0 is the worst case)
+			float acmr{};
+			// Average Transform to Vertex Ratio: transformed vertices per unique vertex (1.0 is optimal)
+			float atvr{};
+		};
+
+		struct OverdrawStatistics
+		{
+			// Shaded pixels per covered pixel, averaged over six axis aligned views (1.0 is optimal)
+			float overdraw{};
+		};
+
+		// The FIFO cache size that is used to optimize and analyze the index buffers
+		constexpr uint32_t VertexCacheSize{ 16 };
+
+		// How much worse (relative) the ACMR of a cluster may get when the vertex cache order is split up to reduce overdraw
+		constexpr float OverdrawThreshold{ 1.05f };
+
+		// The amount of LODs generated per mesh (including the full resolution one), each LOD halves the triangle count
+		constexpr uint32_t MaxLodCount{ 4 };
+
+		// The limits of a single meshlet
+		constexpr uint32_t MaxMeshletVertices{ 64 };
+		constexpr uint32_t MaxMeshletTriangles{ 128 };
+
+		// Reorders the triangles of an indexed triangle list for post-transform cache locality (Tipsify)
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VertexCacheSize);
+
+		// Splits the vertex cache optimized triangle order into clusters and sorts them so outward facing clusters come first [Sander et al. 2007]
+		// Those clusters are likely to occlude the rest of the mesh, so more pixels fail the depth test before they get shaded
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = OverdrawThreshold, uint32_t cacheSize = VertexCacheSize);
+
+		// Reorders the vertices in the order they are first used by the index buffer and remaps the indices
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Collapses edges by lowest quadric error [Garland & Heckbert 1997] until at most targetIndexCount indices remain
+		// The vertices are not changed, the result only references a subset of them. Vertices on UV seams and open borders are kept
+		// pResultError receives the largest error (in object space units) that one of the collapses introduced
+		std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float* pResultError = nullptr);
+
+		// Splits an indexed triangle list into meshlets of neighbouring triangles, following the order of the index buffer
+		std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+			uint32_t maxVertices = MaxMeshletVertices, uint32_t maxTriangles = MaxMeshletTriangles);
+
+		// Compresses the vertices into the quantized format, positions are stored relative to the bounding box
+		std::vector<VertexQuantized> QuantizeVertices(const std::vector<Vertex>& vertices, const BoundingBox& boundingBox);
+
+		// Decodes a quantized vertex, the position is scaled by the size of the bounding box and offset by its minimum
+		Vertex DequantizeVertex(const VertexQuantized& vertex, const Vector3& positionScale, const Vector3& positionOffset);
+
+		// Rasterizes the mesh with depth testing from six axis aligned views to measure how often every covered pixel gets shaded
+		OverdrawStatistics AnalyzeOverdraw(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		// Simulates a FIFO post-transform cache to calculate the ACMR and ATVR of an indexed triangle list
+		VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VertexCacheSize);
+	}
+}
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "PowLookupTable.h"
+#include <chrono>
+
+namespace dae
+{
+	PowLookupTable::PowLookupTable(float maxExponent)
+		: m_MaxExponent{ maxExponent }
+		, m_ExponentScale{ (ExponentSteps - 1) / maxExponent }
+	{
+		m_Table.resize(static_cast<size_t>(ExponentSteps * (BaseSteps + 1)));
+		for (int exponentIdx{}; exponentIdx < ExponentSteps; ++exponentIdx)
+		{
+			const float exponent{ exponentIdx / m_ExponentScale };
+			for (int baseIdx{}; baseIdx <= BaseSteps; ++baseIdx)
+			{
+				const float baseRoot{ static_cast<float>(baseIdx) / BaseSteps };
+				m_Table[exponentIdx * (BaseSteps + 1) + baseIdx] = powf(baseRoot * baseRoot, exponent);
+			}
+		}
+	}
+
+	float PowLookupTable::Lookup(float base, float exponent) const
+	{
+		if (base > 0.0f && base < FirstEntryBase) return powf(base, exponent);
+
+		const int exponentIdx{ std::clamp(static_cast<int>(exponent * m_ExponentScale + 0.5f), 0, ExponentSteps - 1) };
+
+		// Interpolate between the two closest bases
+		const float basePosition{ sqrtf(std::clamp(base, 0.0f, 1.0f)) * BaseSteps };
+		const int baseIdx{ std::min(static_cast<int>(basePosition), BaseSteps - 1) };
+		const float fraction{ basePosition - baseIdx };
+
+		const float* pRow{ m_Table.data() + exponentIdx * (BaseSteps + 1) };
+		return pRow[baseIdx] + (pRow[baseIdx + 1] - pRow[baseIdx]) * fraction;
+	}
+
+	__m128 PowLookupTable::Lookup(__m128 base, __m128 exponent) const
+	{
+		// The rows and bases are found for all lanes at once, only the table reads are done per lane since SSE2 has no gather
+		const __m128i exponentIdx{ _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(exponent, _mm_set1_ps(m_ExponentScale)), _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(ExponentSteps - 1.0f))) };
+		const __m128 basePosition{ _mm_mul_ps(_mm_sqrt_ps(_mm_min_ps(_mm_max_ps(base, _mm_setzero_ps()), _mm_set1_ps(1.0f))), _mm_set1_ps(static_cast<float>(BaseSteps))) };
+		const __m128i baseIdx{ _mm_cvttps_epi32(_mm_min_ps(basePosition, _mm_set1_ps(BaseSteps - 1.0f))) };
+		const __m128 fraction{ _mm_sub_ps(basePosition, _mm_cvtepi32_ps(baseIdx)) };
+
+		alignas(16) int entryIdx[PacketSize];
+		_mm_store_si128(reinterpret_cast<__m128i*>(entryIdx), _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(exponentIdx), _mm_set1_ps(BaseSteps + 1.0f))), baseIdx));
+
+		const float* pTable{ m_Table.data() };
+		const __m128 low{ _mm_setr_ps(pTable[entryIdx[0]], pTable[entryIdx[1]], pTable[entryIdx[2]], pTable[entryIdx[3]]) };
+		const __m128 high{ _mm_setr_ps(pTable[entryIdx[0] + 1], pTable[entryIdx[1] + 1], pTable[entryIdx[2] + 1], pTable[entryIdx[3] + 1]) };
+		const __m128 result{ _mm_add_ps(low, _mm_mul_ps(_mm_sub_ps(high, low), fraction)) };
+
+		// Lanes with a base below the first entry use FastPow, it is only evaluated when one of the lanes needs it
+		const __m128 isBelowFirstEntry{ _mm_and_ps(_mm_cmpgt_ps(base, _mm_setzero_ps()), _mm_cmplt_ps(base, _mm_set1_ps(FirstEntryBase))) };
+		if (!_mm_movemask_ps(isBelowFirstEntry)) return result;
+
+		return _mm_or_ps(_mm_and_ps(isBelowFirstEntry, FastPow(base, exponent)), _mm_andnot_ps(isBelowFirstEntry, result));
+	}
+
+	void PowLookupTable::Benchmark() const
+	{
+		// The exponents an 8-bit glossiness map produces, combined with bases spread over [0, 1]
+		// The bases are spaced like the table entries, so bases below the first entry are tested too
+		constexpr int sampleCount{ 1 << 20 };
+		std::vector<float> bases(sampleCount);
+		std::vector<float> exponents(sampleCount);
+		for (int sampleIdx{}; sampleIdx < sampleCount; ++sampleIdx)
+		{
+			const float baseRoot{ static_cast<float>(sampleIdx % 4099) / 4098 };
+			bases[sampleIdx] = baseRoot * baseRoot;
+			exponents[sampleIdx] = m_MaxExponent * (sampleIdx * 7 % 256) / 255.0f;
+		}
+
+		std::vector<float> exactResults(sampleCount);
+		std::vector<float> polynomialResults(sampleCount);
+		std::vector<float> tableResults(sampleCount);
+
+		// Measures the time (in milliseconds) it takes to evaluate all samples
+		auto measure = [&](auto evaluate)
+			{
+				const auto start{ std::chrono::high_resolution_clock::now() };
+				evaluate();
+				return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			};
+
+		const float exactTime{ measure([&]
+			{
+				for (int sampleIdx{}; sampleIdx < sampleCount; ++sampleIdx)
+				{
+					exactResults[sampleIdx] = powf(bases[sampleIdx], exponents[sampleIdx]);
+				}
+			}) };
+
+		const float polynomialTime{ measure([&]
+			{
+				for (int sampleIdx{}; sampleIdx < sampleCount; sampleIdx += PacketSize)
+				{
+					_mm_storeu_ps(&polynomialResults[sampleIdx], FastPow(_mm_loadu_ps(&bases[sampleIdx]), _mm_loadu_ps(&exponents[sampleIdx])));
+				}
+			}) };
+
+		const float tableTime{ measure([&]
+			{
+				for (int sampleIdx{}; sampleIdx < sampleCount; sampleIdx += PacketSize)
+				{
+					_mm_storeu_ps(&tableResults[sampleIdx], Lookup(_mm_loadu_ps(&bases[sampleIdx]), _mm_loadu_ps(&exponents[sampleIdx])));
+				}
+			}) };
+
+		// The largest absolute error, the results are color intensities in [0, 1]
+		float polynomialError{};
+		float tableError{};
+		for (int sampleIdx{}; sampleIdx < sampleCount; ++sampleIdx)
+		{
+			polynomialError = std::max(polynomialError, abs(polynomialResults[sampleIdx] - exactResults[sampleIdx]));
+			tableError = std::max(tableError, abs(tableResults[sampleIdx] - exactResults[sampleIdx]));
+		}
+
+		std::cout << "Specular pow over " << sampleCount << " samples: powf " << exactTime << " ms"
+			<< ", FastPow " << polynomialTime << " ms (max error " << polynomialError << ")"
+			<< ", lookup table " << tableTime << " ms (max error " << tableError << ", " << sizeof(float) * m_Table.size() << " bytes)\n";
+	}
+}
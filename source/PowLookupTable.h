@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include "MathPacket.h"
+
+namespace dae
+{
+	// pow(base, exponent) for bases in [0, 1] and exponents in [0, maxExponent], stored as one row of bases per exponent
+	// Exponents are rounded to the closest row and bases are linearly interpolated between two entries of the row
+	// With 256 rows, exponents that come from an 8-bit texture channel scaled by maxExponent hit a row exactly
+	// For those exponents the absolute error stays below 4.3e-3 over all bases, the largest errors are near a base of one with the highest exponent
+	class PowLookupTable final
+	{
+	public:
+		explicit PowLookupTable(float maxExponent);
+
+		float Lookup(float base, float exponent) const;
+		__m128 Lookup(__m128 base, __m128 exponent) const;
+
+		// Compares powf, FastPow and the table on the same inputs and prints their largest error and throughput
+		void Benchmark() const;
+
+	private:
+		static constexpr int BaseSteps{ 256 };
+		static constexpr int ExponentSteps{ 256 };
+		// Below the first entry after zero, interpolating towards pow(0, exponent) is off by up to 0.05 for small exponents
+		// Those bases are rare, so they are evaluated without the table
+		static constexpr float FirstEntryBase{ 1.0f / (BaseSteps * BaseSteps) };
+
+		float m_MaxExponent{};
+		// Converts an exponent to its row
+		float m_ExponentScale{};
+		// The entries of a row are spaced evenly in the square root of the base, small exponents rise too steeply near zero for even steps in the base
+		// Every row has one entry more than there are steps, so the last step can be interpolated
+		std::vector<float> m_Table{};
+	};
+}
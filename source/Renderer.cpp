@@ -2,12 +2,15 @@
 #include "Renderer.h"
 #include "HardwareRenderer.h"
 #include "SoftwareRenderer.h"
+#include "SoftwareShaders.h"
 #include "Camera.h"
 #include "Mesh.h"
 #include "Texture.h"
 #include "MaterialShaded.h"
 #include "MaterialTransparent.h"
+#include "SceneBvh.h"
 #include <memory>
+#include <stdexcept>
 
 namespace dae {
 
@@ -29,6 +32,10 @@ namespace dae {
 		// Load all the textures and meshes
 		LoadResources();
 
+		// Build the hierarchy over all mesh instances
+		m_pSceneBvh = std::make_unique<SceneBvh>();
+		m_pSceneBvh->Build(m_pMeshVec);
+
 		// Show keybinds
 		SetConsoleTextAttribute(m_hConsole, 14); // 14 is the color code for yellow
 		std::cout << "[Key Bindings - SHARED]\n";
@@ -37,11 +44,12 @@ namespace dae {
 		std::cout << "\t[F9]  Cycle CullMode (BACK / FRONT / NONE)\n";
 		std::cout << "\t[F10] Toggle Uniform ClearColor (ON / OFF)\n";
 		std::cout << "\t[F11] Toggle Print FPS (ON / OFF)\n";
+		std::cout << "\t[F3]  Toggle FireFX (ON / OFF)\n";
+		std::cout << "\t[1]   Toggle Fleet Overview (ON / OFF)\n";
 		std::cout << "\n";
 
 		SetConsoleTextAttribute(m_hConsole, 10); // 10 is the color code for green
 		std::cout << "[Key Bindings - HARDWARE]\n";
-		std::cout << "\t[F3] Toggle FireFX (ON / OFF)\n";
 		std::cout << "\t[F4] Cycle Sampler State (POINT / LINEAR / ANISOTROPIC)\n";
 		std::cout << "\n";
 
@@ -52,6 +60,12 @@ namespace dae {
 		std::cout << "\t[F7] Toggle DepthBuffer Visualization (ON / OFF)\n";
 		std::cout << "\t[F8] Toggle BoundingBox Visualization (ON / OFF)\n";
 		std::cout << "\t[0] Toggle Multithreading (Synchronous / Async/ Parallel_for)\n";
+		std::cout << "\t[2] Toggle Streamed Vehicle (ON / OFF)\n";
+		std::cout << "\t[3] Cycle Specular Pow (POWF / FAST_POW / LOOKUP_TABLE)\n";
+		std::cout << "\t[4] Toggle Transparency (SORTED / WEIGHTED_BLENDED)\n";
+		std::cout << "\t[5] Cycle Shading Rate (1X1 / 2X2 / 4X4 / ADAPTIVE)\n";
+		std::cout << "\t[6] Toggle Deferred Lighting with Point Lights (ON / OFF)\n";
+		std::cout << "\t[7] Benchmark Specular Pow (POWF / FAST_POW / LOOKUP_TABLE)\n";
 		std::cout << "\n\n";
 		std::cout << "I added Async threading and parallel_for threading to the Software rasterizer\n";
 	}
@@ -75,12 +89,13 @@ namespace dae {
 		switch (m_RenderMode)
 		{
 		case dae::Renderer::RenderMode::Software:
-			// Render the scene using the software rasterizer
-			m_pSoftwareRenderer->Render(m_pCamera, m_IsBackgroundUniform);
+			// Render the scene using the software rasterizer, or show the previous frame again if it would be the same
+			if (m_IsFrameUnchanged) m_pSoftwareRenderer->PresentPreviousFrame();
+			else m_pSoftwareRenderer->Render(m_pDrawList, m_pCamera, m_IsBackgroundUniform);
 			break;
 		case dae::Renderer::RenderMode::Hardware:
 			// Render the scene using the software rasterizer
-			m_pHardwareRenderer->Render(m_pMeshVec, m_IsBackgroundUniform);
+			m_pHardwareRenderer->Render(m_pDrawList, m_IsBackgroundUniform);
 			break;
 		}
 	}
@@ -93,12 +108,85 @@ namespace dae {
 		// Calculate viewprojection matrix
 		const Matrix ViewProjMatrix{ m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix() };
 
+		// Extract the camera frustum to cull the meshes against
+		const Frustum frustum{ Frustum::FromViewProjection(ViewProjMatrix) };
+
+		// The amount of pixels one unit covers at a distance of one unit, used to project the LOD errors on screen
+		const float pixelsPerUnit{ m_Height * 0.5f * m_pCamera->GetProjectionMatrix()[1][1] };
+		const Vector3 cameraPosition{ m_pCamera->GetInverseViewMatrix().GetTranslation() };
+
 		//Rotate meshes
 		const float rotationSpeed{ 45.0f * TO_RADIANS };
 		for (Mesh* pMesh : m_pMeshVec)
 		{
 			if(m_IsMeshRotating) pMesh->RotateY(rotationSpeed * pTimer->GetElapsed());
+		}
+
+		// Refit the hierarchy to the meshes that moved and cull all instances with it
+		m_pSceneBvh->Update();
+		m_pSceneBvh->CullFrustum(frustum);
+
+		for (Mesh* pMesh : m_pMeshVec)
+		{
+			pMesh->SelectLod(cameraPosition, pixelsPerUnit);
 			pMesh->SetMatrices(ViewProjMatrix, m_pCamera->GetInverseViewMatrix());
+
+			// Page in the clusters the software rasterizer will need
+			if (m_RenderMode == RenderMode::Software) pMesh->StreamVisibleClusters(ViewProjMatrix, cameraPosition);
+		}
+
+		SortDrawList();
+
+		// Compare everything that influences the rendered image with the previous frame
+		FrameState frameState{ m_SettingsVersion, m_pCamera->GetVersion(), 0 };
+		for (const Mesh* pMesh : m_pMeshVec)
+		{
+			frameState.meshVersions += pMesh->GetWorldMatrixVersion() + pMesh->GetResidencyVersion();
+		}
+
+		m_IsFrameUnchanged = frameState == m_PreviousFrameState;
+		m_PreviousFrameState = frameState;
+	}
+
+	bool Renderer::IsFrameUnchanged() const
+	{
+		return m_IsFrameUnchanged;
+	}
+
+	void Renderer::MarkSettingsChanged()
+	{
+		++m_SettingsVersion;
+	}
+
+	void Renderer::SortDrawList()
+	{
+		// Sort on the view depth of the bounding sphere centers
+		const Matrix& viewMatrix{ m_pCamera->GetViewMatrix() };
+
+		std::vector<std::pair<float, Mesh*>> opaqueMeshes{};
+		std::vector<std::pair<float, Mesh*>> transparentMeshes{};
+		for (Mesh* pMesh : m_pMeshVec)
+		{
+			if (!pMesh->IsInFrustum()) continue;
+
+			const float viewDepth{ viewMatrix.TransformPoint(pMesh->GetWorldBoundingSphere().center).z };
+			(pMesh->IsTransparent() ? transparentMeshes : opaqueMeshes).emplace_back(viewDepth, pMesh);
+		}
+
+		// Opaque meshes front to back so the depth test rejects as much as possible, transparent meshes back to front so they blend correctly
+		auto isCloser = [](const std::pair<float, Mesh*>& a, const std::pair<float, Mesh*>& b) { return a.first < b.first; };
+		auto isFurther = [](const std::pair<float, Mesh*>& a, const std::pair<float, Mesh*>& b) { return a.first > b.first; };
+		std::stable_sort(opaqueMeshes.begin(), opaqueMeshes.end(), isCloser);
+		std::stable_sort(transparentMeshes.begin(), transparentMeshes.end(), isFurther);
+
+		m_pDrawList.clear();
+		for (const std::pair<float, Mesh*>& mesh : opaqueMeshes)
+		{
+			m_pDrawList.push_back(mesh.second);
+		}
+		for (const std::pair<float, Mesh*>& mesh : transparentMeshes)
+		{
+			m_pDrawList.push_back(mesh.second);
 		}
 	}
 
@@ -130,8 +218,8 @@ namespace dae {
 		vehicleMaterial->SetTexture(pSpecularText);
 		vehicleMaterial->SetTexture(pGlossText);
 
-		// Create the vehicle mesh and add it to the list of meshes
-		Mesh* pVehicle{ new Mesh{ pDirectXDevice, "Resources/vehicle.obj", vehicleMaterial, pSampleState } };
+		// Create the vehicle mesh with compact vertices and add it to the list of meshes
+		Mesh* pVehicle{ new Mesh{ pDirectXDevice, "Resources/vehicle.obj", vehicleMaterial, pSampleState, VertexFormat::Quantized } };
 		pVehicle->SetPosition({ 0.0f, 0.0f, 50.0f });
 		m_pMeshVec.push_back(pVehicle);
 
@@ -150,11 +238,45 @@ namespace dae {
 		pFire->SetPosition({ 0.0f, 0.0f, 50.0f });
 		m_pMeshVec.push_back(pFire);
 
+		// Create the streamed copy of the vehicle, it keeps at most the memory budget of its clusters in memory
+		constexpr size_t streamingBudget{ 256 * 1024 * 1024 };
+		// The scene works without it, it is left out when its clusters cannot be streamed
+		MaterialShaded* streamedVehicleMaterial{ new MaterialShaded{ pDirectXDevice, L"Resources/PosTex3D.fx" } };
+		try
+		{
+			m_pStreamedVehicle = new Mesh{ "Resources/vehicle.obj", "Resources/vehicle.clusters", streamingBudget, streamedVehicleMaterial };
+			m_pStreamedVehicle->SetPosition({ -25.0f, 0.0f, 80.0f });
+			m_pStreamedVehicle->SetVisibility(false);
+			m_pMeshVec.push_back(m_pStreamedVehicle);
+		}
+		catch (const std::runtime_error& error)
+		{
+			std::cout << error.what() << "\n";
+			delete streamedVehicleMaterial;
+		}
+
 
 		
-		// Set the software renderer to render the vehicle
-		m_pSoftwareRenderer->SetMesh(pVehicle);
-		m_pSoftwareRenderer->SetTextures(pVehicleDiffText, pNormalText, pSpecularText, pGlossText);
+		// Give the software renderer the textures to render the meshes with
+		m_pSoftwareRenderer->SetMaterial(pVehicle, { pVehicleDiffText, pNormalText, pSpecularText, pGlossText });
+		m_pSoftwareRenderer->SetMaterial(pFire, { pFireDiffuseTexture, nullptr, nullptr, nullptr, GetSoftwareShaderIdx<SoftwareUnlitShader>() });
+		if (m_pStreamedVehicle) m_pSoftwareRenderer->SetMaterial(m_pStreamedVehicle, { pVehicleDiffText, pNormalText, pSpecularText, pGlossText });
+
+		// Spread a grid of colored point lights over the area of the fleet, only the deferred mode of the software renderer uses them
+		constexpr int lightGridWidth{ 16 };
+		constexpr int lightGridDepth{ 8 };
+		const ColorRGB lightColors[]{ { 1.0f, 0.3f, 0.3f }, { 0.3f, 1.0f, 0.3f }, { 0.3f, 0.3f, 1.0f }, { 1.0f, 0.8f, 0.3f } };
+
+		std::vector<SoftwarePointLight> pointLights{};
+		for (int z{}; z < lightGridDepth; ++z)
+		{
+			for (int x{}; x < lightGridWidth; ++x)
+			{
+				const ColorRGB& lightColor{ lightColors[(x + z) % std::size(lightColors)] };
+				pointLights.push_back({ { -100.0f + x * 12.0f, 8.0f, z * 25.0f }, lightColor, 7.0f, 15.0f });
+			}
+		}
+		m_pSoftwareRenderer->SetPointLights(pointLights);
 	}
 
 	void Renderer::ToggleRenderMode()
@@ -173,6 +295,8 @@ namespace dae {
 			std::cout << "HARDWARE\n";
 			break;
 		}
+
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleMeshRotation()
@@ -189,18 +313,18 @@ namespace dae {
 		{
 			std::cout << "OFF\n";
 		}
+
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleFireMesh()
 	{
-		if (m_RenderMode != RenderMode::Hardware) return;
-
 		Mesh* pFireMesh{ m_pMeshVec[1] };
 
 		pFireMesh->SetVisibility(!pFireMesh->IsVisible());
 
 		SetConsoleTextAttribute(m_hConsole, 14); // 14 is the color code for yellow
-		std::cout << "**(HARDWARE)FireFX ";
+		std::cout << "**(SHARED) FireFX ";
 		if (pFireMesh->IsVisible())
 		{
 			std::cout << "ON\n";
@@ -209,6 +333,8 @@ namespace dae {
 		{
 			std::cout << "OFF\n";
 		}
+
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleSamplerState()
@@ -216,6 +342,7 @@ namespace dae {
 		if (m_RenderMode != RenderMode::Hardware) return;
 
 		m_pHardwareRenderer->ToggleSampleState(m_pMeshVec);
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleShadingMode()
@@ -223,6 +350,7 @@ namespace dae {
 		if (m_RenderMode != RenderMode::Software) return;
 
 		m_pSoftwareRenderer->ToggleLightingMode();
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleNormalMap()
@@ -230,6 +358,7 @@ namespace dae {
 		if (m_RenderMode != RenderMode::Software) return;
 
 		m_pSoftwareRenderer->ToggleNormalMap();
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleShowingDepthBuffer()
@@ -237,6 +366,7 @@ namespace dae {
 		if (m_RenderMode != RenderMode::Software) return;
 
 		m_pSoftwareRenderer->ToggleDepthBuffer();
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleShowingBoundingBoxes()
@@ -244,6 +374,7 @@ namespace dae {
 		if (m_RenderMode != RenderMode::Software) return;
 
 		m_pSoftwareRenderer->ToggleBoundingBoxVisible();
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleUniformBackground()
@@ -260,6 +391,8 @@ namespace dae {
 		{
 			std::cout << "OFF\n";
 		}
+
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleCulling()
@@ -284,12 +417,115 @@ namespace dae {
 
 		m_pSoftwareRenderer->SetCulling(m_CullMode);
 		m_pHardwareRenderer->SetCulling(m_CullMode, m_pMeshVec);
+
+		MarkSettingsChanged();
 	}
 
 	void Renderer::ToggleMultiThreading()
 	{
 		if (m_RenderMode != RenderMode::Software) return;
 		m_pSoftwareRenderer->ToggleMultiThreading();
+		MarkSettingsChanged();
+	}
+
+	void Renderer::ToggleFleet()
+	{
+		m_IsFleetVisible = !m_IsFleetVisible;
+
+		// Draw the vehicle and its fire on a grid of instances, every instance rotates around its own center
+		constexpr int fleetWidth{ 10 };
+		constexpr int fleetDepth{ 10 };
+		constexpr float spacing{ 20.0f };
+
+		std::vector<Matrix> instanceMatrices{};
+		if (m_IsFleetVisible)
+		{
+			for (int z{}; z < fleetDepth; ++z)
+			{
+				for (int x{}; x < fleetWidth; ++x)
+				{
+					instanceMatrices.push_back(Matrix::CreateTranslation((x - fleetWidth / 2) * spacing, 0.0f, z * spacing));
+				}
+			}
+		}
+
+		for (Mesh* pMesh : m_pMeshVec)
+		{
+			pMesh->SetInstances(m_pHardwareRenderer->GetDevice(), instanceMatrices);
+		}
+
+		SetConsoleTextAttribute(m_hConsole, 14); // 14 is the color code for yellow
+		std::cout << "**(SHARED) Fleet Overview ";
+		if (m_IsFleetVisible)
+		{
+			std::cout << "ON\n";
+		}
+		else
+		{
+			std::cout << "OFF\n";
+		}
+
+		MarkSettingsChanged();
+	}
+
+	void Renderer::ToggleStreamedVehicle()
+	{
+		if (m_RenderMode != RenderMode::Software || !m_pStreamedVehicle) return;
+
+		m_pStreamedVehicle->SetVisibility(!m_pStreamedVehicle->IsVisible());
+
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) Streamed Vehicle ";
+		if (m_pStreamedVehicle->IsVisible())
+		{
+			std::cout << "ON\n";
+		}
+		else
+		{
+			std::cout << "OFF\n";
+		}
+
+		MarkSettingsChanged();
+	}
+
+	void Renderer::ToggleSpecularPow()
+	{
+		if (m_RenderMode != RenderMode::Software) return;
+
+		m_pSoftwareRenderer->ToggleSpecularPow();
+		MarkSettingsChanged();
+	}
+
+	void Renderer::BenchmarkSpecularPow() const
+	{
+		// The benchmark does not change the rendered image, so the cached frame stays valid
+		if (m_RenderMode != RenderMode::Software) return;
+
+		m_pSoftwareRenderer->BenchmarkSpecularPow();
+	}
+
+	void Renderer::ToggleTransparencyMode()
+	{
+		if (m_RenderMode != RenderMode::Software) return;
+
+		m_pSoftwareRenderer->ToggleTransparencyMode();
+		MarkSettingsChanged();
+	}
+
+	void Renderer::ToggleShadingRate()
+	{
+		if (m_RenderMode != RenderMode::Software) return;
+
+		m_pSoftwareRenderer->ToggleShadingRate();
+		MarkSettingsChanged();
+	}
+
+	void Renderer::ToggleDeferredLighting()
+	{
+		if (m_RenderMode != RenderMode::Software) return;
+
+		m_pSoftwareRenderer->ToggleDeferredLighting();
+		MarkSettingsChanged();
 	}
 
-}
+}
\ No newline at end of file
@@ -12,6 +12,7 @@ namespace dae
 	class Camera;
 	class Mesh;
 	class Texture;
+	class SceneBvh;
 
 	class Renderer final
 	{
@@ -27,6 +28,7 @@ namespace dae
 
 		void Update(const Timer* pTimer);
 		void Render() const;
+		bool IsFrameUnchanged() const;
 		void ToggleRenderMode();
 		void ToggleMeshRotation();
 		void ToggleFireMesh();
@@ -38,6 +40,13 @@ namespace dae
 		void ToggleUniformBackground();
 		void ToggleCulling();
 		void ToggleMultiThreading();
+		void ToggleFleet();
+		void ToggleStreamedVehicle();
+		void ToggleSpecularPow();
+		void BenchmarkSpecularPow() const;
+		void ToggleTransparencyMode();
+		void ToggleShadingRate();
+		void ToggleDeferredLighting();
 
 	private:
 		enum class RenderMode
@@ -56,17 +65,45 @@ namespace dae
 		std::unique_ptr <Camera> m_pCamera{};
 
 		std::vector<Mesh*> m_pMeshVec{};
+
+		// The hierarchy over all mesh instances, used to frustum cull them
+		std::unique_ptr<SceneBvh> m_pSceneBvh{};
+
+		// The visible meshes in the order they are rendered: opaque front to back, then transparent back to front
+		std::vector<Mesh*> m_pDrawList{};
 		std::vector<Texture*> m_pTextVec{};
 
+		// Everything that changes the rendered image, when it stays the same the previous frame can be shown again
+		struct FrameState
+		{
+			// Increases every time a setting is toggled
+			uint32_t settingsVersion{};
+			uint32_t cameraVersion{};
+			// The sum of the world matrix and residency versions of all meshes, versions only increase so any change alters the sum
+			uint32_t meshVersions{};
+
+			bool operator==(const FrameState& other) const = default;
+		};
+		FrameState m_PreviousFrameState{};
+		uint32_t m_SettingsVersion{ 1 };
+		bool m_IsFrameUnchanged{};
+
 		RenderMode m_RenderMode{ RenderMode::Hardware };
 		CullMode m_CullMode{ CullMode::Back };
 		bool m_IsMeshRotating{ true };
 		bool m_IsBackgroundUniform{};
+		bool m_IsFleetVisible{};
+
+		// A copy of the vehicle that is streamed from a cluster file, only rendered by the software rasterizer
+		Mesh* m_pStreamedVehicle{};
 
 
 		std::unique_ptr <HardwareRenderer> m_pHardwareRenderer{};
 		std::unique_ptr <SoftwareRenderer> m_pSoftwareRenderer{};
 
 		void LoadResources();
+		void SortDrawList();
+		// Called by the toggles once they changed a setting, so the next frame is rendered again
+		void MarkSettingsChanged();
 	};
 }
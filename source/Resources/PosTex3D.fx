@@ -8,9 +8,21 @@ float gShininess = 25.0f;
 float3 gLightDirection = normalize(float3(0.577f, -0.577f, 0.577f));
 
 float4x4 gWorldViewProj : WorldViewProjection;
+
+// Dequantization of VertexFormat::Quantized positions (the bounding box size and minimum of the mesh)
+float3 gPositionScale : PositionScale;
+float3 gPositionOffset : PositionOffset;
 float4x4 gWorld : World;
 float4x4 gViewInverse : ViewInverse;
 
+// Instancing, the world matrix of every instance is read with its instance id
+struct INSTANCE
+{
+	row_major float4x4 World;
+};
+StructuredBuffer<INSTANCE> gInstances : Instances;
+float4x4 gViewProj : ViewProjection;
+
 Texture2D gDiffuseMap : DiffuseMap;
 Texture2D gNormalMap : NormalMap;
 Texture2D gSpecularMap : SpecularMap;
@@ -53,6 +65,14 @@ struct VS_INPUT
 	float2 UV		: TEXCOORD;
 };
 
+struct VS_INPUT_QUANTIZED
+{
+	float4 Position	: POSITION;
+	float2 Normal	: NORMAL;
+	float2 Tangent	: TANGENT;
+	float2 UV		: TEXCOORD;
+};
+
 struct VS_OUTPUT
 {
 	float4 Position			: SV_POSITION;
@@ -65,17 +85,56 @@ struct VS_OUTPUT
 //------------------------------------------------
 // Vertex Shader
 //------------------------------------------------
-VS_OUTPUT VS(VS_INPUT input)
+VS_OUTPUT TransformVertex(VS_INPUT input, float4x4 world, float4x4 worldViewProj)
 {
 	VS_OUTPUT output = (VS_OUTPUT)0;
-	output.Position = mul(float4(input.Position, 1.0f), gWorldViewProj);
-	output.WorldPosition = mul(float4(input.Position, 1.0f), gWorld);
-	output.Tangent = mul(normalize(input.Tangent), (float3x3)gWorld);
-	output.Normal = mul(normalize(input.Normal), (float3x3)gWorld);
+	output.Position = mul(float4(input.Position, 1.0f), worldViewProj);
+	output.WorldPosition = mul(float4(input.Position, 1.0f), world);
+	output.Tangent = mul(normalize(input.Tangent), (float3x3)world);
+	output.Normal = mul(normalize(input.Normal), (float3x3)world);
 	output.UV = input.UV;
 	return output;
 }
 
+VS_OUTPUT VS(VS_INPUT input)
+{
+	return TransformVertex(input, gWorld, gWorldViewProj);
+}
+
+VS_OUTPUT VS_Instanced(VS_INPUT input, uint instanceId : SV_InstanceID)
+{
+	float4x4 world = gInstances[instanceId].World;
+	return TransformVertex(input, world, mul(world, gViewProj));
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.0f ? -t : t;
+	return normalize(direction);
+}
+
+VS_INPUT DecodeVertex(VS_INPUT_QUANTIZED input)
+{
+	VS_INPUT decoded = (VS_INPUT)0;
+	decoded.Position = input.Position.xyz * gPositionScale + gPositionOffset;
+	decoded.Normal = DecodeOctahedral(input.Normal);
+	decoded.Tangent = DecodeOctahedral(input.Tangent);
+	decoded.UV = input.UV;
+	return decoded;
+}
+
+VS_OUTPUT VS_Quantized(VS_INPUT_QUANTIZED input)
+{
+	return VS(DecodeVertex(input));
+}
+
+VS_OUTPUT VS_QuantizedInstanced(VS_INPUT_QUANTIZED input, uint instanceId : SV_InstanceID)
+{
+	return VS_Instanced(DecodeVertex(input), instanceId);
+}
+
 //------------------------------------------------
 // BRDF Calculation
 //------------------------------------------------
@@ -129,4 +188,43 @@ technique11 DefaultTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(CompileShader(ps_5_0, PS()));
 	}
+}
+
+technique11 QuantizedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Quantized()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 InstancedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Instanced()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 QuantizedInstancedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_QuantizedInstanced()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
 }
\ No newline at end of file
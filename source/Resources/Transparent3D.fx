@@ -3,6 +3,18 @@
 //------------------------------------------------
 float4x4 gWorldViewProj : WorldViewProjection;
 
+// Dequantization of VertexFormat::Quantized positions (the bounding box size and minimum of the mesh)
+float3 gPositionScale : PositionScale;
+float3 gPositionOffset : PositionOffset;
+
+// Instancing, the world matrix of every instance is read with its instance id
+struct INSTANCE
+{
+	row_major float4x4 World;
+};
+StructuredBuffer<INSTANCE> gInstances : Instances;
+float4x4 gViewProj : ViewProjection;
+
 Texture2D gDiffuseMap : DiffuseMap;
 
 SamplerState gSamState : SampleState
@@ -48,6 +60,14 @@ struct VS_INPUT
 	float2 UV		: TEXCOORD;
 };
 
+struct VS_INPUT_QUANTIZED
+{
+	float4 Position	: POSITION;
+	float2 Normal	: NORMAL;
+	float2 Tangent	: TANGENT;
+	float2 UV		: TEXCOORD;
+};
+
 struct VS_OUTPUT
 {
 	float4 Position			: SV_POSITION;
@@ -57,14 +77,52 @@ struct VS_OUTPUT
 //------------------------------------------------
 // Vertex Shader
 //------------------------------------------------
-VS_OUTPUT VS(VS_INPUT input)
+VS_OUTPUT TransformVertex(VS_INPUT input, float4x4 worldViewProj)
 {
 	VS_OUTPUT output = (VS_OUTPUT)0;
-	output.Position = mul(float4(input.Position, 1.0f), gWorldViewProj);
+	output.Position = mul(float4(input.Position, 1.0f), worldViewProj);
 	output.UV = input.UV;
 	return output;
 }
 
+VS_OUTPUT VS(VS_INPUT input)
+{
+	return TransformVertex(input, gWorldViewProj);
+}
+
+VS_OUTPUT VS_Instanced(VS_INPUT input, uint instanceId : SV_InstanceID)
+{
+	return TransformVertex(input, mul(gInstances[instanceId].World, gViewProj));
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.0f ? -t : t;
+	return normalize(direction);
+}
+
+VS_INPUT DecodeVertex(VS_INPUT_QUANTIZED input)
+{
+	VS_INPUT decoded = (VS_INPUT)0;
+	decoded.Position = input.Position.xyz * gPositionScale + gPositionOffset;
+	decoded.Normal = DecodeOctahedral(input.Normal);
+	decoded.Tangent = DecodeOctahedral(input.Tangent);
+	decoded.UV = input.UV;
+	return decoded;
+}
+
+VS_OUTPUT VS_Quantized(VS_INPUT_QUANTIZED input)
+{
+	return VS(DecodeVertex(input));
+}
+
+VS_OUTPUT VS_QuantizedInstanced(VS_INPUT_QUANTIZED input, uint instanceId : SV_InstanceID)
+{
+	return VS_Instanced(DecodeVertex(input), instanceId);
+}
+
 //------------------------------------------------
 // Pixel Shader
 //------------------------------------------------
@@ -87,4 +145,43 @@ technique11 DefaultTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(CompileShader(ps_5_0, PS()));
 	}
+}
+
+technique11 QuantizedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Quantized()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 InstancedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_Instanced()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 QuantizedInstancedTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_QuantizedInstanced()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
 }
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "SceneBvh.h"
+#include "Mesh.h"
+#include <numeric>
+
+namespace dae
+{
+	void SceneBvh::Build(const std::vector<Mesh*>& pMeshes)
+	{
+		m_Meshes.clear();
+		m_Instances.clear();
+
+		// Collect the world bounds of every instance, meshes that failed to load have no bounds and are never visible
+		for (Mesh* pMesh : pMeshes)
+		{
+			if (!pMesh->IsLoaded()) continue;
+
+			const uint32_t meshIdx{ static_cast<uint32_t>(m_Meshes.size()) };
+			m_Meshes.push_back(MeshState{ pMesh, pMesh->GetWorldMatrixVersion(), pMesh->GetInstanceCount(), static_cast<uint32_t>(m_Instances.size()) });
+
+			for (uint32_t instanceIdx{}; instanceIdx < pMesh->GetInstanceCount(); ++instanceIdx)
+			{
+				Instance instance{ meshIdx, instanceIdx };
+				instance.worldBounds = CalculateInstanceBounds(instance);
+				m_Instances.push_back(instance);
+			}
+		}
+
+		m_InstanceOrder.resize(m_Instances.size());
+		std::iota(m_InstanceOrder.begin(), m_InstanceOrder.end(), 0);
+
+		// Split the instances top down, children are always stored after their parent
+		m_Nodes.clear();
+		m_Nodes.push_back(Node{ {}, 0, 0, 0, static_cast<uint32_t>(m_Instances.size()) });
+		BuildNode(0);
+
+		m_IsNodeDirty.assign(m_Nodes.size(), false);
+	}
+
+	void SceneBvh::Update()
+	{
+		// Instances were added or removed, the hierarchy has to be built again
+		for (const MeshState& meshState : m_Meshes)
+		{
+			if (meshState.pMesh->GetInstanceCount() == meshState.instanceCount) continue;
+
+			std::vector<Mesh*> pMeshes{};
+			for (const MeshState& state : m_Meshes)
+			{
+				pMeshes.push_back(state.pMesh);
+			}
+			Build(pMeshes);
+			return;
+		}
+
+		// Update the bounds of the instances of every mesh that moved and mark the nodes above them
+		bool isAnyNodeDirty{};
+		for (MeshState& meshState : m_Meshes)
+		{
+			if (meshState.pMesh->GetWorldMatrixVersion() == meshState.worldMatrixVersion) continue;
+			meshState.worldMatrixVersion = meshState.pMesh->GetWorldMatrixVersion();
+
+			for (uint32_t instanceIdx{ meshState.firstInstanceIdx }; instanceIdx < meshState.firstInstanceIdx + meshState.instanceCount; ++instanceIdx)
+			{
+				Instance& instance{ m_Instances[instanceIdx] };
+				instance.worldBounds = CalculateInstanceBounds(instance);
+
+				// Stop at the first node that is already marked, the nodes above it are marked too
+				uint32_t nodeIdx{ instance.leafIdx };
+				while (!m_IsNodeDirty[nodeIdx])
+				{
+					m_IsNodeDirty[nodeIdx] = true;
+					if (nodeIdx == 0) break;
+					nodeIdx = m_Nodes[nodeIdx].parentIdx;
+				}
+				isAnyNodeDirty = true;
+			}
+		}
+
+		if (!isAnyNodeDirty) return;
+
+		// Children are stored after their parent, so walking backwards refits the children before their parents
+		for (size_t nodeIdx{ m_Nodes.size() }; nodeIdx-- > 0;)
+		{
+			if (!m_IsNodeDirty[nodeIdx]) continue;
+
+			RefitNode(static_cast<uint32_t>(nodeIdx));
+			m_IsNodeDirty[nodeIdx] = false;
+		}
+	}
+
+	void SceneBvh::CullFrustum(const Frustum& frustum) const
+	{
+		for (const MeshState& meshState : m_Meshes)
+		{
+			meshState.pMesh->ClearVisibleInstances();
+		}
+
+		if (m_Instances.empty()) return;
+
+		std::vector<uint32_t> nodeStack{ 0 };
+		while (!nodeStack.empty())
+		{
+			const Node& node{ m_Nodes[nodeStack.back()] };
+			nodeStack.pop_back();
+
+			// Skip the whole subtree when its bounds are outside, accept it without further tests when they are inside
+			if (frustum.IsOutside(node.bounds)) continue;
+
+			if (frustum.Contains(node.bounds))
+			{
+				AddVisibleInstances(node);
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t orderIdx{ node.firstIdx }; orderIdx < node.firstIdx + node.count; ++orderIdx)
+				{
+					const Instance& instance{ m_Instances[m_InstanceOrder[orderIdx]] };
+					if (frustum.IsOutside(instance.worldBounds)) continue;
+
+					m_Meshes[instance.meshIdx].pMesh->AddVisibleInstance(instance.instanceIdx);
+				}
+				continue;
+			}
+
+			nodeStack.push_back(node.childIdx + 1);
+			nodeStack.push_back(node.childIdx);
+		}
+	}
+
+	void SceneBvh::BuildNode(uint32_t nodeIdx)
+	{
+		const uint32_t firstIdx{ m_Nodes[nodeIdx].firstIdx };
+		const uint32_t count{ m_Nodes[nodeIdx].count };
+
+		// Calculate the bounds of the instances and of their centers
+		BoundingBox bounds{};
+		BoundingBox centerBounds{};
+		for (uint32_t orderIdx{ firstIdx }; orderIdx < firstIdx + count; ++orderIdx)
+		{
+			const BoundingBox& instanceBounds{ m_Instances[m_InstanceOrder[orderIdx]].worldBounds };
+			bounds.Grow(instanceBounds);
+			centerBounds.Grow(instanceBounds.GetCenter());
+		}
+		m_Nodes[nodeIdx].bounds = bounds;
+
+		if (count <= MaxLeafSize)
+		{
+			for (uint32_t orderIdx{ firstIdx }; orderIdx < firstIdx + count; ++orderIdx)
+			{
+				m_Instances[m_InstanceOrder[orderIdx]].leafIdx = nodeIdx;
+			}
+			return;
+		}
+
+		// Split at the median center along the axis the centers are spread out the most
+		const Vector3 centerExtents{ centerBounds.GetExtents() };
+		const int axis{ centerExtents.x >= centerExtents.y && centerExtents.x >= centerExtents.z ? 0 : (centerExtents.y >= centerExtents.z ? 1 : 2) };
+
+		const uint32_t leftCount{ count / 2 };
+		std::nth_element(m_InstanceOrder.begin() + firstIdx, m_InstanceOrder.begin() + firstIdx + leftCount, m_InstanceOrder.begin() + firstIdx + count,
+			[&](uint32_t a, uint32_t b) { return m_Instances[a].worldBounds.GetCenter()[axis] < m_Instances[b].worldBounds.GetCenter()[axis]; });
+
+		const uint32_t childIdx{ static_cast<uint32_t>(m_Nodes.size()) };
+		m_Nodes[nodeIdx].childIdx = childIdx;
+		m_Nodes.push_back(Node{ {}, nodeIdx, 0, firstIdx, leftCount });
+		m_Nodes.push_back(Node{ {}, nodeIdx, 0, firstIdx + leftCount, count - leftCount });
+
+		BuildNode(childIdx);
+		BuildNode(childIdx + 1);
+	}
+
+	void SceneBvh::RefitNode(uint32_t nodeIdx)
+	{
+		Node& node{ m_Nodes[nodeIdx] };
+
+		BoundingBox bounds{};
+		if (node.IsLeaf())
+		{
+			for (uint32_t orderIdx{ node.firstIdx }; orderIdx < node.firstIdx + node.count; ++orderIdx)
+			{
+				bounds.Grow(m_Instances[m_InstanceOrder[orderIdx]].worldBounds);
+			}
+		}
+		else
+		{
+			bounds.Grow(m_Nodes[node.childIdx].bounds);
+			bounds.Grow(m_Nodes[node.childIdx + 1].bounds);
+		}
+		node.bounds = bounds;
+	}
+
+	BoundingBox SceneBvh::CalculateInstanceBounds(const Instance& instance) const
+	{
+		const Mesh* pMesh{ m_Meshes[instance.meshIdx].pMesh };
+		return pMesh->GetBoundingBox().Transformed(pMesh->GetInstanceWorldMatrix(instance.instanceIdx));
+	}
+
+	void SceneBvh::AddVisibleInstances(const Node& node) const
+	{
+		// The instances of a node are next to each other, so the whole subtree is added at once
+		for (uint32_t orderIdx{ node.firstIdx }; orderIdx < node.firstIdx + node.count; ++orderIdx)
+		{
+			const Instance& instance{ m_Instances[m_InstanceOrder[orderIdx]] };
+			m_Meshes[instance.meshIdx].pMesh->AddVisibleInstance(instance.instanceIdx);
+		}
+	}
+}
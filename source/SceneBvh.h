@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "BoundingVolumes.h"
+
+namespace dae
+{
+	class Mesh;
+
+	// A bounding volume hierarchy over the world bounds of every mesh instance, used to frustum cull them hierarchically
+	class SceneBvh final
+	{
+	public:
+		// Builds the hierarchy over every instance of the meshes
+		void Build(const std::vector<Mesh*>& pMeshes);
+
+		// Refits the bounds of the instances whose mesh moved since the last update, instances that were added or removed rebuild the hierarchy
+		void Update();
+
+		// Replaces the visible instances of every mesh by the ones that are (partially) inside the frustum
+		void CullFrustum(const Frustum& frustum) const;
+
+	private:
+		// The maximum amount of instances in a leaf
+		static constexpr uint32_t MaxLeafSize{ 4 };
+
+		struct MeshState
+		{
+			Mesh* pMesh{};
+			uint32_t worldMatrixVersion{};
+			uint32_t instanceCount{};
+			// The first instance of the mesh in m_Instances
+			uint32_t firstInstanceIdx{};
+		};
+
+		struct Instance
+		{
+			uint32_t meshIdx{};
+			uint32_t instanceIdx{};
+			BoundingBox worldBounds{};
+			uint32_t leafIdx{};
+		};
+
+		struct Node
+		{
+			BoundingBox bounds{};
+			uint32_t parentIdx{};
+			// The left child, the right child follows it. Leaves have no children
+			uint32_t childIdx{};
+			// Every node covers a contiguous range of m_InstanceOrder
+			uint32_t firstIdx{};
+			uint32_t count{};
+
+			bool IsLeaf() const { return childIdx == 0; }
+		};
+
+		std::vector<MeshState> m_Meshes{};
+		std::vector<Instance> m_Instances{};
+		// The instances sorted so the instances of every node are next to each other
+		std::vector<uint32_t> m_InstanceOrder{};
+		std::vector<Node> m_Nodes{};
+		std::vector<uint8_t> m_IsNodeDirty{};
+
+		void BuildNode(uint32_t nodeIdx);
+		void RefitNode(uint32_t nodeIdx);
+		BoundingBox CalculateInstanceBounds(const Instance& instance) const;
+		void AddVisibleInstances(const Node& node) const;
+	};
+}
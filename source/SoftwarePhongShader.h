@@ -0,0 +1,172 @@
+#pragma once
+#include "SoftwareShader.h"
+#include "Utils.h"
+
+namespace dae
+{
+	// The default shader of the software rasterizer, Lambert diffuse and Phong specular from one directional light
+	struct SoftwarePhongShader final
+	{
+		// The directional light of the scene, the deferred mode adds its point lights to it
+		static constexpr float LightIntensity{ 7.0f };
+		static constexpr float AmbientIntensity{ 0.025f };
+		static Vector3 GetLightDirection()
+		{
+			Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
+			lightDirection.Normalize();
+			return lightDirection;
+		}
+
+		static Vertex_Out ShadeVertex(const Vertex& vertex, const VertexShaderConstants& constants)
+		{
+			// Create a new vertex
+			Vertex_Out vOut{ {}, vertex.normal, vertex.tangent, vertex.uv, vertex.color };
+
+			// Tranform the vertex using the inversed view matrix
+			vOut.position = constants.worldViewProjectionMatrix.TransformPoint({ vertex.position, 1.0f });
+
+			// Calculate the view direction in world space, like the lighting pass of the deferred mode does
+			vOut.viewDirection = constants.worldMatrix.TransformPoint(vertex.position) - constants.cameraPosition;
+			vOut.viewDirection.Normalize();
+
+			// Transform the normal and the tangent of the vertex
+			vOut.normal = constants.worldMatrix.TransformVector(vertex.normal);
+			vOut.tangent = constants.worldMatrix.TransformVector(vertex.tangent);
+
+			return vOut;
+		}
+
+		static constexpr Varyings GetVaryings(ShadingModes modes)
+		{
+			return Varyings
+			{
+				modes.useNormalMap || modes.lightingMode != LightingMode::ObservedArea,
+				true,
+				modes.useNormalMap,
+				modes.lightingMode == LightingMode::Combined || modes.lightingMode == LightingMode::Specular
+			};
+		}
+
+		// The lighting pass reconstructs the view direction from the depth
+		static constexpr Varyings GetSurfaceVaryings(ShadingModes modes)
+		{
+			Varyings varyings{ GetVaryings(modes) };
+			varyings.viewDirection = false;
+			return varyings;
+		}
+
+		template<ShadingModes Modes>
+		static ColorRGBPacket ShadePixels(const PixelShaderInput& input)
+		{
+			const SurfacePacket surface{ ShadeSurface<Modes>(input) };
+
+			// The view direction is only used by the specular
+			Vector3Packet viewDirection{};
+			if constexpr (Modes.lightingMode == LightingMode::Combined || Modes.lightingMode == LightingMode::Specular)
+			{
+				viewDirection = input.Gather(&Vertex_Out::viewDirection);
+			}
+
+			// Evaluates the specular power the way that was chosen for this frame
+			auto specularPow = [&input](__m128 base, __m128 exponent) { return input.SpecularPow(base, exponent); };
+
+			// The final color that will be rendered
+			ColorRGBPacket finalColor{ ShadeLight<Modes.lightingMode>(surface, Vector3Packet::Splat(-GetLightDirection()), viewDirection, _mm_set1_ps(LightIntensity), ColorRGBPacket::Splat({ 1.0f, 1.0f, 1.0f }), specularPow) };
+			finalColor += GetAmbientColor<Modes.lightingMode>();
+			return finalColor;
+		}
+
+		template<ShadingModes Modes>
+		static SurfacePacket ShadeSurface(const PixelShaderInput& input)
+		{
+			const SoftwareMaterial& material{ *input.pMaterial };
+			SurfacePacket surface{};
+
+			// The normal that should be used in calculations
+			const Vector3Packet normal{ input.Gather(&Vertex_Out::normal) };
+			surface.normal = normal;
+
+			// If the normal map is active
+			if constexpr (Modes.useNormalMap)
+			{
+				// Calculate the binormal in these pixels
+				const Vector3Packet tangent{ input.Gather(&Vertex_Out::tangent) };
+				const Vector3Packet binormal{ Vector3Packet::Cross(normal, tangent) };
+
+				// Sample a color from the normal map and remap it between -1 and 1
+				const ColorRGBPacket normalMapColor{ input.SampleTexture(material.pNormalTexture) };
+				const __m128 two{ _mm_set1_ps(2.0f) };
+				const __m128 one{ _mm_set1_ps(1.0f) };
+
+				// Transform the normal map value with the tangent space axis (tangent, binormal, normal) of every pixel
+				surface.normal = tangent * _mm_sub_ps(_mm_mul_ps(two, normalMapColor.r), one)
+					+ binormal * _mm_sub_ps(_mm_mul_ps(two, normalMapColor.g), one)
+					+ normal * _mm_sub_ps(_mm_mul_ps(two, normalMapColor.b), one);
+			}
+			surface.normal = surface.normal.Normalized();
+
+			// Only sample the textures the lighting mode uses
+			if constexpr (Modes.lightingMode == LightingMode::Combined || Modes.lightingMode == LightingMode::Diffuse)
+			{
+				surface.diffuse = input.SampleTexture(material.pDiffuseTexture);
+			}
+			if constexpr (Modes.lightingMode == LightingMode::Combined || Modes.lightingMode == LightingMode::Specular)
+			{
+				surface.specular = input.SampleTexture(material.pSpecularTexture);
+				// Fetch the phong exponent
+				surface.exponent = input.SampleExponent(material.pGlossinessTexture);
+			}
+			return surface;
+		}
+
+		// The light one light adds to the surface, the color of the light is already attenuated
+		template<LightingMode Mode, typename PowFunction>
+		static ColorRGBPacket ShadeLight(const SurfacePacket& surface, const Vector3Packet& toLight, const Vector3Packet& viewDirection, __m128 lightIntensity, const ColorRGBPacket& lightColor, PowFunction specularPow)
+		{
+			// Calculate the observed area in these pixels
+			const __m128 observedArea{ Vector3Packet::DotClamped(surface.normal, toLight) };
+
+			// Depending on the lighting mode, different shading should be applied, the mode is known at compile time so only its case remains
+			switch (Mode)
+			{
+				case LightingMode::Combined:
+				{
+					// Calculate the lambert shader
+					const ColorRGBPacket lambert{ LightingUtils::Lambert(1.0f, surface.diffuse) };
+					// Calculate the phong shader
+					const ColorRGBPacket specular{ surface.specular * LightingUtils::Phong(1.0f, surface.exponent, toLight, viewDirection, surface.normal, specularPow) };
+
+					// Lambert + Phong + ObservedArea
+					return (lambert * lightIntensity + specular) * lightColor * observedArea;
+				}
+				case LightingMode::ObservedArea:
+				{
+					// Only show the calculated observed area
+					return ColorRGBPacket{ observedArea, observedArea, observedArea } * lightColor;
+				}
+				case LightingMode::Diffuse:
+				{
+					// Calculate the lambert shader and display it on screen together with the observed area
+					return LightingUtils::Lambert(1.0f, surface.diffuse) * lightColor * _mm_mul_ps(lightIntensity, observedArea);
+				}
+				case LightingMode::Specular:
+				{
+					// Calculate the phong shader
+					const ColorRGBPacket specular{ surface.specular * LightingUtils::Phong(1.0f, surface.exponent, toLight, viewDirection, surface.normal, specularPow) };
+					// Phong + observed area
+					return specular * lightColor * observedArea;
+				}
+			}
+			return ColorRGBPacket{};
+		}
+
+		// The ambient color is added once after all lights, the combined mode has always added it twice
+		template<LightingMode Mode>
+		static ColorRGBPacket GetAmbientColor()
+		{
+			const ColorRGBPacket ambientColor{ ColorRGBPacket::Splat({ AmbientIntensity, AmbientIntensity, AmbientIntensity }) };
+			if constexpr (Mode == LightingMode::Combined) return ambientColor + ambientColor;
+			else return ambientColor;
+		}
+	};
+}
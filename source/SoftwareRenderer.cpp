@@ -4,6 +4,10 @@
 #include "Camera.h"
 #include "Texture.h"
 #include "Utils.h"
+#include "MeshOptimizer.h"
+#include "ClusterStreamer.h"
+#include "SoftwareShaders.h"
+#include <bit>
 #include <ppl.h> // Parallel Stuff
 #include <thread>
 #include <future>
@@ -23,502 +27,1465 @@ namespace dae
 		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
 		m_pDepthBufferPixels = new float[static_cast<uint32_t>(m_Width * m_Height)];
 		ResetDepthBuffer();
+		m_pAccumulationPixels = new float[static_cast<uint32_t>(m_Width * m_Height * 4)];
+		m_pRevealagePixels = new float[static_cast<uint32_t>(m_Width * m_Height)];
+
+		// Split the screen into tiles that are only rendered again when they change
+		m_NrTilesX = (m_Width + TileSize - 1) / TileSize;
+		m_NrTilesY = (m_Height + TileSize - 1) / TileSize;
+		m_IsTileDirty.resize(static_cast<size_t>(m_NrTilesX * m_NrTilesY));
+		m_TileBins.resize(m_IsTileDirty.size());
+		m_pTileShadingBlockSizes = new uint8_t[m_IsTileDirty.size()];
+		std::fill_n(m_pTileShadingBlockSizes, m_IsTileDirty.size(), static_cast<uint8_t>(1));
+		m_TransparentTileBins.resize(m_IsTileDirty.size());
+		m_TileLights.resize(m_IsTileDirty.size());
+		m_pGBuffer = new GBufferTexel[static_cast<uint32_t>(m_Width * m_Height)];
+
 	}
 
 	dae::SoftwareRenderer::~SoftwareRenderer()
 	{
 		delete[] m_pDepthBufferPixels;
+		delete[] m_pAccumulationPixels;
+		delete[] m_pRevealagePixels;
+		delete[] m_pTileShadingBlockSizes;
+		delete[] m_pGBuffer;
 	}
-	void dae::SoftwareRenderer::Render(const std::unique_ptr<Camera>& pCamera, bool useUniformBackground)
+	void dae::SoftwareRenderer::Render(const std::vector<Mesh*>& pMeshes, const std::unique_ptr<Camera>& pCamera, bool useUniformBackground)
 	{
-		// Reset the depth buffer and paint the canvas black in one step
-		ResetDepthBuffer();
-		ClearBackground(useUniformBackground);
+		// The whole screen is rendered again when the view or a setting changed, otherwise only the tiles of the draw items that changed
+		const bool isFullRedraw{ m_IsFullRedrawNeeded || pCamera->GetVersion() != m_PreviousCameraVersion || useUniformBackground != m_PreviousUseUniformBackground };
+		m_IsFullRedrawNeeded = false;
+		m_PreviousCameraVersion = pCamera->GetVersion();
+		m_PreviousUseUniformBackground = useUniformBackground;
+		std::fill(m_IsTileDirty.begin(), m_IsTileDirty.end(), static_cast<uint8_t>(isFullRedraw));
+
+		CollectDrawItems(pMeshes, *pCamera);
+
+		// The transformed vertices and binned triangles of the previous frame are reused when none of the draw items changed
+		const bool isTransformValid
+		{
+			std::equal(m_DrawItems.begin(), m_DrawItems.end(), m_PreviousDrawItems.begin(), m_PreviousDrawItems.end(),
+				[](const DrawItem& a, const DrawItem& b) { return a.transformState == b.transformState; })
+		};
+
+		if (isTransformValid)
+		{
+			m_DrawItems = m_PreviousDrawItems;
+			if (m_IsBinningNeeded) BinTriangles();
+		}
+		else
+		{
+			TransformDrawItems(*pCamera);
+			MarkChangedDrawItems();
+			BinTriangles();
+		}
+		m_IsBinningNeeded = false;
+
+		// The point lights are binned again every frame, there are few enough of them
+		if (IsLightingDeferred())
+		{
+			m_ViewProjectionMatrix = pCamera->GetViewMatrix() * pCamera->GetProjectionMatrix();
+			m_InverseViewMatrix = pCamera->GetInverseViewMatrix();
+			m_InverseProjectionScale = { 1.0f / pCamera->GetProjectionMatrix()[0][0], 1.0f / pCamera->GetProjectionMatrix()[1][1] };
+			BinPointLights();
+		}
 
 		//Lock BackBuffer
 		SDL_LockSurface(m_pBackBuffer);
 
-		if (m_pMesh)
+		RenderTiles(useUniformBackground);
+		
+		if (m_ThreadModeChange)
 		{
-			std::vector<Vertex_Out> verticesOut;
+			m_ThreadMode = m_NextMode;
+			m_ThreadModeChange = false;
+		}
 
-			// Convert all the vertices in the mesh from world space to NDC space
-			VertexTransformationFunction(verticesOut, pCamera);
+		//Update SDL Surface
+		SDL_UnlockSurface(m_pBackBuffer);
+		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
 
-			// Create a vector for all the vertices in raster space
-			std::vector<Vector2> verticesRasterSpace;
+		std::swap(m_DrawItems, m_PreviousDrawItems);
+	}
 
-			// Convert all the vertices from NDC space to raster space in one step
-			for (const Vertex_Out& ndcVertex : verticesOut)
+	void SoftwareRenderer::PresentPreviousFrame() const
+	{
+		// The back buffer still holds the last rendered frame
+		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+
+	void SoftwareRenderer::SetMaterial(const Mesh* pMesh, const SoftwareMaterial& material)
+	{
+		m_Materials[pMesh] = material;
+		m_IsFullRedrawNeeded = true;
+
+		// The specular exponent of every texel is calculated once instead of for every shaded pixel
+		if (material.pGlossinessTexture) material.pGlossinessTexture->CreateExponentMap(SpecularShininess);
+
+		// Decode quantized vertices once, so the instances of the mesh do not each decode them again
+		if (pMesh->GetVertexFormat() == VertexFormat::Quantized && !m_DecodedVertices.contains(pMesh))
+		{
+			const BoundingBox& boundingBox{ pMesh->GetBoundingBox() };
+			const Vector3 positionScale{ boundingBox.max - boundingBox.min };
+
+			std::vector<Vertex>& decodedVertices{ m_DecodedVertices[pMesh] };
+			decodedVertices.reserve(pMesh->GetVertexCount());
+			for (const VertexQuantized& vertex : pMesh->GetQuantizedVertices())
 			{
-				verticesRasterSpace.push_back(CalculateNDCToRaster(ndcVertex.position));
+				decodedVertices.push_back(MeshOptimizer::DequantizeVertex(vertex, positionScale, boundingBox.min));
 			}
+		}
+	}
 
-			std::vector<uint32_t>& indices{ m_pMesh->GetIndices() };
-			std::vector<std::future<void>> asyncFutures{};
-			unsigned int nrCores{ std::thread::hardware_concurrency() };
-			unsigned int trianglesPerTask{};
-			unsigned int remainingTriangles{};
-			unsigned int curTriangleIdx{};
+	void SoftwareRenderer::SetCulling(CullMode cullMode)
+	{
+		m_CullMode = cullMode;
+		m_IsFullRedrawNeeded = true;
+	}
+
+	void SoftwareRenderer::SetPointLights(const std::vector<SoftwarePointLight>& pointLights)
+	{
+		m_PointLights = pointLights;
+		m_IsFullRedrawNeeded = true;
+	}
+
+	void SoftwareRenderer::CollectDrawItems(const std::vector<Mesh*>& pMeshes, Camera& camera)
+	{
+		m_DrawItems.clear();
+		for (Mesh* pMesh : pMeshes)
+		{
+			const auto materialIt{ m_Materials.find(pMesh) };
+			if (materialIt == m_Materials.end() || !pMesh->IsVisible() || !pMesh->IsInFrustum()) continue;
+
+			// Both sides of transparent meshes are visible, like in the hardware rasterizer
+			const bool isTransparent{ pMesh->IsTransparent() };
+			const CullMode cullMode{ isTransparent ? CullMode::None : m_CullMode };
+
+			// Every instance that is (partially) inside the camera frustum is a separate draw item
+			for (uint32_t instanceIdx : pMesh->GetVisibleInstances())
+			{
+				DrawItem drawItem{};
+				drawItem.pMesh = pMesh;
+				drawItem.pMaterial = &materialIt->second;
+				drawItem.transformState = { pMesh, pMesh->GetWorldMatrixVersion(), camera.GetVersion(), &pMesh->GetCurrentLod(), cullMode, instanceIdx, pMesh->GetResidencyVersion() };
+				drawItem.isTransparent = isTransparent;
+				m_DrawItems.push_back(drawItem);
+			}
+		}
+	}
+
+	void SoftwareRenderer::MarkChangedDrawItems()
+	{
+		m_PreviousDrawItemIndices.clear();
+		for (size_t previousIdx{}; previousIdx < m_PreviousDrawItems.size(); ++previousIdx)
+		{
+			const TransformState& transformState{ m_PreviousDrawItems[previousIdx].transformState };
+			m_PreviousDrawItemIndices.emplace(DrawItemKey{ transformState.pMesh, transformState.instanceIdx }, previousIdx);
+		}
+
+		// The tiles of a draw item that changed are rendered again, where it was in the previous frame and where it is now
+		for (const DrawItem& drawItem : m_DrawItems)
+		{
+			const auto previousIt{ m_PreviousDrawItemIndices.find(DrawItemKey{ drawItem.transformState.pMesh, drawItem.transformState.instanceIdx }) };
+			if (previousIt == m_PreviousDrawItemIndices.end())
+			{
+				MarkDirtyTiles(drawItem.footprint);
+				continue;
+			}
+
+			const DrawItem& previousDrawItem{ m_PreviousDrawItems[previousIt->second] };
+			if (previousDrawItem.transformState != drawItem.transformState)
+			{
+				MarkDirtyTiles(drawItem.footprint);
+				MarkDirtyTiles(previousDrawItem.footprint);
+			}
+
+			// Only the previous draw items that are not drawn anymore stay in the map
+			m_PreviousDrawItemIndices.erase(previousIt);
+		}
+
+		// Draw items that are not visible anymore leave their tiles behind
+		for (const auto& [key, previousIdx] : m_PreviousDrawItemIndices)
+		{
+			MarkDirtyTiles(m_PreviousDrawItems[previousIdx].footprint);
+		}
+	}
+
+	void SoftwareRenderer::MarkDirtyTiles(const ScreenRect& rect)
+	{
+		if (rect.minX >= rect.maxX || rect.minY >= rect.maxY) return;
+
+		for (int tileY{ rect.minY / TileSize }; tileY <= (rect.maxY - 1) / TileSize; ++tileY)
+		{
+			for (int tileX{ rect.minX / TileSize }; tileX <= (rect.maxX - 1) / TileSize; ++tileX)
+			{
+				m_IsTileDirty[tileX + tileY * m_NrTilesX] = true;
+			}
+		}
+	}
+
+	void SoftwareRenderer::TransformDrawItems(Camera& camera)
+	{
+		const Matrix viewProjectionMatrix{ camera.GetViewMatrix() * camera.GetProjectionMatrix() };
+		const Vector3 cameraPosition{ camera.GetInverseViewMatrix().GetTranslation() };
+
+		// All draw items add their vertices and triangles to the ones of the frame
+		m_VerticesOut.clear();
+		m_VerticesRasterSpace.clear();
+		m_Triangles.clear();
+
+		for (uint32_t drawItemIdx{}; drawItemIdx < m_DrawItems.size(); ++drawItemIdx)
+		{
+			const size_t firstVertexIdx{ m_VerticesOut.size() };
+
+			// The vertex stage is specialized for the shader of the draw item
+			const TransformDrawItemFunction pTransformDrawItem{ GetShaderKernels(m_DrawItems[drawItemIdx].pMaterial->shaderIdx).pTransformDrawItem };
+			(this->*pTransformDrawItem)(drawItemIdx, viewProjectionMatrix, cameraPosition);
+
+			m_DrawItems[drawItemIdx].footprint = CalculateFootprint(firstVertexIdx, m_VerticesOut.size());
+		}
+	}
+
+	template<SoftwareShader Shader>
+	void SoftwareRenderer::TransformDrawItem(uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition)
+	{
+		Mesh* pMesh{ m_DrawItems[drawItemIdx].pMesh };
+
+		// Fetch the indices with the width the mesh stores them in, streamed meshes only have the indices of their resident clusters
+		if (pMesh->IsStreamed())
+		{
+			TransformStreamedDrawItem<Shader>(drawItemIdx, viewProjectionMatrix, cameraPosition);
+		}
+		else if (pMesh->Uses16BitIndices())
+		{
+			TransformMeshDrawItem<Shader>(pMesh->GetIndices16(), m_VisibleIndices16, drawItemIdx, viewProjectionMatrix, cameraPosition);
+		}
+		else
+		{
+			TransformMeshDrawItem<Shader>(pMesh->GetIndices(), m_VisibleIndices, drawItemIdx, viewProjectionMatrix, cameraPosition);
+		}
+	}
+
+	template<SoftwareShader Shader, typename IndexType>
+	void SoftwareRenderer::TransformMeshDrawItem(const std::vector<IndexType>& meshIndices, std::vector<IndexType>& visibleIndices, uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition)
+	{
+		const DrawItem& drawItem{ m_DrawItems[drawItemIdx] };
+		Mesh* pMesh{ drawItem.pMesh };
+
+		// Calculate the transformation matrix for this instance
+		const Matrix worldMatrix{ pMesh->GetInstanceWorldMatrix(drawItem.transformState.instanceIdx) };
+		const Matrix worldViewProjectionMatrix{ worldMatrix * viewProjectionMatrix };
+		const Vector3 objectSpaceCameraPosition{ Matrix::Inverse(worldMatrix).TransformPoint(cameraPosition) };
+
+		// Cull the meshlets in object space, so their bounds and cones do not have to be transformed
+		CullMeshlets(pMesh, meshIndices, visibleIndices, worldViewProjectionMatrix, objectSpaceCameraPosition, drawItem.transformState.cullMode);
+
+		// Convert all the used vertices in the mesh from world space to NDC space
+		const size_t firstVertexIdx{ m_VerticesOut.size() };
+		VertexTransformationFunction<Shader>(pMesh, { worldMatrix, worldViewProjectionMatrix, cameraPosition });
+
+		// Convert all the new vertices from NDC space to raster space in one step
+		ConvertVerticesToRasterSpace(firstVertexIdx);
+
+		SetupTriangles(visibleIndices, drawItemIdx);
+	}
+
+	template<SoftwareShader Shader>
+	void SoftwareRenderer::TransformStreamedDrawItem(uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition)
+	{
+		const DrawItem& drawItem{ m_DrawItems[drawItemIdx] };
+		const ClusterStreamer& clusterStreamer{ *drawItem.pMesh->GetClusterStreamer() };
+
+		// Calculate the transformation matrix for this instance
+		const Matrix worldMatrix{ drawItem.pMesh->GetInstanceWorldMatrix(drawItem.transformState.instanceIdx) };
+		const Matrix worldViewProjectionMatrix{ worldMatrix * viewProjectionMatrix };
+		const Vector3 objectSpaceCameraPosition{ Matrix::Inverse(worldMatrix).TransformPoint(cameraPosition) };
+		const VertexShaderConstants constants{ worldMatrix, worldViewProjectionMatrix, cameraPosition };
+
+		// Cull the resident clusters like meshlets, clusters that are still on disk are left out until they are loaded
+		CollectVisibleMeshlets(0, clusterStreamer.GetClusterCount(),
+			[&clusterStreamer](uint32_t clusterIdx) { return clusterStreamer.IsResident(clusterIdx) ? &clusterStreamer.GetCluster(clusterIdx) : nullptr; },
+			worldViewProjectionMatrix, objectSpaceCameraPosition, drawItem.transformState.cullMode);
+
+		// Every cluster has its own vertices, the remap table translates the local indices of all clusters to the vertices of the frame
+		const size_t firstVertexIdx{ m_VerticesOut.size() };
+		m_VisibleIndices.clear();
+		m_VertexRemap.clear();
+		for (const std::pair<float, uint32_t>& visibleCluster : m_VisibleMeshlets)
+		{
+			const uint32_t clusterIdx{ visibleCluster.second };
+			const uint32_t firstLocalIdx{ static_cast<uint32_t>(m_VertexRemap.size()) };
+
+			const Vertex* pVertices{ clusterStreamer.GetClusterVertices(clusterIdx) };
+			for (uint32_t vertexIdx{}; vertexIdx < clusterStreamer.GetClusterVertexCount(clusterIdx); ++vertexIdx)
+			{
+				m_VertexRemap.push_back(static_cast<uint32_t>(m_VerticesOut.size()));
+				m_VerticesOut.push_back(TransformVertex<Shader>(pVertices[vertexIdx], constants));
+			}
 
-			// Depending on the topology of the mesh, use indices differently
-			switch (m_pMesh->GetPrimitiveTopology())
+			const uint8_t* pIndices{ clusterStreamer.GetClusterIndices(clusterIdx) };
+			for (uint32_t idx{}; idx < clusterStreamer.GetCluster(clusterIdx).triangleCount * 3; ++idx)
 			{
-			case PrimitiveTopology::TriangleList:
-				// For each triangle
-				switch (m_ThreadMode)
+				m_VisibleIndices.push_back(firstLocalIdx + pIndices[idx]);
+			}
+		}
+
+		// Convert all the new vertices from NDC space to raster space in one step
+		ConvertVerticesToRasterSpace(firstVertexIdx);
+
+		SetupTriangles(m_VisibleIndices, drawItemIdx);
+	}
+
+	template<typename IndexType>
+	void SoftwareRenderer::SetupTriangles(const std::vector<IndexType>& indices, uint32_t drawItemIdx)
+	{
+		for (size_t firstIdx{}; firstIdx + 2 < indices.size(); firstIdx += 3)
+		{
+			const uint32_t vertexIdx0{ indices[firstIdx] };
+			const uint32_t vertexIdx1{ indices[firstIdx + 1] };
+			const uint32_t vertexIdx2{ indices[firstIdx + 2] };
+
+			// If a triangle has the same vertex twice, skip it
+			if (vertexIdx0 == vertexIdx1 || vertexIdx1 == vertexIdx2 || vertexIdx0 == vertexIdx2) continue;
+
+			const RasterTriangle triangle{ m_VertexRemap[vertexIdx0], m_VertexRemap[vertexIdx1], m_VertexRemap[vertexIdx2], drawItemIdx };
+
+			// If a one of the vertices is outside the frustum, skip it
+			if (IsOutsideFrustum(m_VerticesOut[triangle.vertexIdx0].position) ||
+				IsOutsideFrustum(m_VerticesOut[triangle.vertexIdx1].position) ||
+				IsOutsideFrustum(m_VerticesOut[triangle.vertexIdx2].position)) continue;
+
+			// If the triangle area is 0 or NaN, skip it
+			const Vector2 v0{ m_VerticesRasterSpace[triangle.vertexIdx0] };
+			const float fullTriangleArea{ Vector2::Cross(m_VerticesRasterSpace[triangle.vertexIdx1] - v0, m_VerticesRasterSpace[triangle.vertexIdx2] - v0) };
+			if (abs(fullTriangleArea) < FLT_EPSILON || isnan(fullTriangleArea)) continue;
+
+			m_Triangles.push_back(triangle);
+		}
+	}
+
+	void SoftwareRenderer::ConvertVerticesToRasterSpace(size_t firstVertexIdx)
+	{
+		m_VerticesRasterSpace.resize(m_VerticesOut.size());
+		for (size_t vertexIdx{ firstVertexIdx }; vertexIdx < m_VerticesOut.size(); ++vertexIdx)
+		{
+			m_VerticesRasterSpace[vertexIdx] = CalculateNDCToRaster(m_VerticesOut[vertexIdx].position);
+		}
+	}
+
+	SoftwareRenderer::ScreenRect SoftwareRenderer::CalculateFootprint(size_t firstVertexIdx, size_t endVertexIdx) const
+	{
+		// The screen area of the vertices, triangles with a vertex outside the frustum are never rendered so those vertices are ignored
+		Vector2 minPoint{ FLT_MAX, FLT_MAX };
+		Vector2 maxPoint{ -FLT_MAX, -FLT_MAX };
+		for (size_t vertexIdx{ firstVertexIdx }; vertexIdx < endVertexIdx; ++vertexIdx)
+		{
+			if (IsOutsideFrustum(m_VerticesOut[vertexIdx].position)) continue;
+
+			minPoint = Vector2::Min(minPoint, m_VerticesRasterSpace[vertexIdx]);
+			maxPoint = Vector2::Max(maxPoint, m_VerticesRasterSpace[vertexIdx]);
+		}
+
+		// Include the margin RenderTriangle adds around every triangle
+		constexpr int margin{ 2 };
+		ScreenRect footprint{};
+		if (minPoint.x <= maxPoint.x)
+		{
+			footprint.minX = std::clamp(static_cast<int>(minPoint.x) - margin, 0, m_Width);
+			footprint.minY = std::clamp(static_cast<int>(minPoint.y) - margin, 0, m_Height);
+			footprint.maxX = std::clamp(static_cast<int>(maxPoint.x) + margin, 0, m_Width);
+			footprint.maxY = std::clamp(static_cast<int>(maxPoint.y) + margin, 0, m_Height);
+		}
+		return footprint;
+	}
+
+	template<typename IndexType>
+	void SoftwareRenderer::CullMeshlets(const Mesh* pMesh, const std::vector<IndexType>& indices, std::vector<IndexType>& visibleIndices, const Matrix& worldViewProjectionMatrix, const Vector3& objectSpaceCameraPosition, CullMode cullMode)
+	{
+		const std::vector<Meshlet>& meshlets{ pMesh->GetMeshlets() };
+		const MeshLod& lod{ pMesh->GetCurrentLod() };
+
+		visibleIndices.clear();
+		m_IsVertexUsed.assign(pMesh->GetVertexCount(), false);
+
+		// Only the meshlets of the current LOD are rendered
+		CollectVisibleMeshlets(lod.meshletOffset, lod.meshletOffset + lod.meshletCount,
+			[&meshlets](uint32_t meshletIdx) { return &meshlets[meshletIdx]; },
+			worldViewProjectionMatrix, objectSpaceCameraPosition, cullMode);
+
+		for (const std::pair<float, uint32_t>& visibleMeshlet : m_VisibleMeshlets)
+		{
+			const Meshlet& meshlet{ meshlets[visibleMeshlet.second] };
+
+			const auto meshletBegin{ indices.begin() + meshlet.indexOffset };
+			const auto meshletEnd{ meshletBegin + meshlet.triangleCount * 3 };
+
+			// Mark the vertices of the meshlet so they get transformed
+			for (auto indexIt{ meshletBegin }; indexIt != meshletEnd; ++indexIt)
+			{
+				m_IsVertexUsed[*indexIt] = true;
+			}
+
+			visibleIndices.insert(visibleIndices.end(), meshletBegin, meshletEnd);
+		}
+	}
+
+	template<typename MeshletFunction>
+	void SoftwareRenderer::CollectVisibleMeshlets(uint32_t firstMeshletIdx, uint32_t endMeshletIdx, MeshletFunction getMeshlet, const Matrix& worldViewProjectionMatrix, const Vector3& objectSpaceCameraPosition, CullMode cullMode)
+	{
+		// Extracting the frustum from the world view projection matrix gives the planes in object space
+		const Frustum frustum{ Frustum::FromViewProjection(worldViewProjectionMatrix) };
+
+		m_VisibleMeshlets.clear();
+		for (uint32_t meshletIdx{ firstMeshletIdx }; meshletIdx < endMeshletIdx; ++meshletIdx)
+		{
+			const Meshlet* pMeshlet{ getMeshlet(meshletIdx) };
+			if (!pMeshlet) continue;
+
+			// Skip meshlets that are outside the frustum or that only contain culled faces
+			if (frustum.IsOutside(pMeshlet->boundingSphere) || IsMeshletFacingAway(*pMeshlet, objectSpaceCameraPosition, cullMode)) continue;
+
+			const float sqrDistance{ (pMeshlet->boundingSphere.center - objectSpaceCameraPosition).SqrMagnitude() };
+			m_VisibleMeshlets.emplace_back(sqrDistance, meshletIdx);
+		}
+
+		// Rasterize the closest meshlets first, so the meshlets behind them fail the depth test before they get shaded
+		std::sort(m_VisibleMeshlets.begin(), m_VisibleMeshlets.end());
+	}
+
+	bool SoftwareRenderer::IsMeshletFacingAway(const Meshlet& meshlet, const Vector3& objectSpaceCameraPosition, CullMode cullMode) const
+	{
+		if (cullMode == CullMode::None) return false;
+
+		// When culling front faces, the meshlet can be skipped if all its triangles face the camera
+		const Vector3 coneAxis{ cullMode == CullMode::Back ? meshlet.coneAxis : -meshlet.coneAxis };
+
+		// Front faces have their normal pointing to the camera, the whole cone has to point away (including the sphere radius)
+		const Vector3 cameraToCenter{ meshlet.boundingSphere.center - objectSpaceCameraPosition };
+		return Vector3::Dot(cameraToCenter, coneAxis) >= meshlet.coneCutoff * cameraToCenter.Magnitude() + meshlet.boundingSphere.radius;
+	}
+
+	template<SoftwareShader Shader>
+	void dae::SoftwareRenderer::VertexTransformationFunction(Mesh* pMesh, const VertexShaderConstants& constants)
+	{
+		// Quantized vertices were decoded when the material of the mesh was set
+		const std::vector<Vertex>& vertices{ pMesh->GetVertexFormat() == VertexFormat::Quantized ? m_DecodedVertices.at(pMesh) : pMesh->GetVertices() };
+		const size_t vertexCount{ pMesh->GetVertexCount() };
+
+		// Only the used vertices are added to the vertices of the frame, the remap table translates the mesh indices
+		m_VertexRemap.resize(vertexCount);
+
+		// For each used vertex in the mesh
+		for (size_t vertexIdx{}; vertexIdx < vertexCount; ++vertexIdx)
+		{
+			if (!m_IsVertexUsed[vertexIdx]) continue;
+
+			// Add the new vertex to the list of NDC vertices
+			m_VertexRemap[vertexIdx] = static_cast<uint32_t>(m_VerticesOut.size());
+			m_VerticesOut.push_back(TransformVertex<Shader>(vertices[vertexIdx], constants));
+		}
+	}
+
+	template<SoftwareShader Shader>
+	Vertex_Out SoftwareRenderer::TransformVertex(const Vertex& vertex, const VertexShaderConstants& constants) const
+	{
+		// The shader returns the position in clip space
+		Vertex_Out vOut{ Shader::ShadeVertex(vertex, constants) };
+
+		// Divide all properties of the position by the original z (stored in position.w)
+		vOut.position.x /= vOut.position.w;
+		vOut.position.y /= vOut.position.w;
+		vOut.position.z /= vOut.position.w;
+
+		return vOut;
+	}
+
+	void SoftwareRenderer::BinTriangles()
+	{
+		for (std::vector<uint32_t>& tileBin : m_TileBins)
+		{
+			tileBin.clear();
+		}
+		for (std::vector<uint32_t>& tileBin : m_TransparentTileBins)
+		{
+			tileBin.clear();
+		}
+
+		// Add every triangle to the bins of the tiles its bounding box overlaps, in draw order
+		for (uint32_t triangleIdx{}; triangleIdx < m_Triangles.size(); ++triangleIdx)
+		{
+			const RasterTriangle& triangle{ m_Triangles[triangleIdx] };
+			const Vector2 minBoundingBox{ Vector2::Min(m_VerticesRasterSpace[triangle.vertexIdx0], Vector2::Min(m_VerticesRasterSpace[triangle.vertexIdx1], m_VerticesRasterSpace[triangle.vertexIdx2])) };
+			const Vector2 maxBoundingBox{ Vector2::Max(m_VerticesRasterSpace[triangle.vertexIdx0], Vector2::Max(m_VerticesRasterSpace[triangle.vertexIdx1], m_VerticesRasterSpace[triangle.vertexIdx2])) };
+
+			// The same bounds and margin RenderTriangle uses
+			constexpr int margin{ 1 };
+			const int startX{ std::max(static_cast<int>(minBoundingBox.x - margin), 0) };
+			const int startY{ std::max(static_cast<int>(minBoundingBox.y - margin), 0) };
+			const int endX{ std::min(static_cast<int>(maxBoundingBox.x + margin), m_Width) };
+			const int endY{ std::min(static_cast<int>(maxBoundingBox.y + margin), m_Height) };
+			if (startX >= endX || startY >= endY) continue;
+
+			// Transparent triangles are kept apart, so they can be blended after all opaque ones
+			std::vector<std::vector<uint32_t>>& tileBins{ m_DrawItems[triangle.drawItemIdx].isTransparent ? m_TransparentTileBins : m_TileBins };
+			for (int tileY{ startY / TileSize }; tileY <= (endY - 1) / TileSize; ++tileY)
+			{
+				for (int tileX{ startX / TileSize }; tileX <= (endX - 1) / TileSize; ++tileX)
 				{
-				case dae::ThreadMode::Synchronous:
-					for (int curStartVertexIdx = 0; curStartVertexIdx < indices.size(); curStartVertexIdx += 3)
-					{
-						RenderTriangle(verticesRasterSpace, verticesOut, indices, curStartVertexIdx, false);
-					}
-					break;
-				case dae::ThreadMode::Async:
-					trianglesPerTask = indices.size() / (3 * nrCores);
-					remainingTriangles = indices.size() % (3 * nrCores);
-					curTriangleIdx = 0; // Initialize curTriangleIdx
-					for (unsigned int coreIdx = 0; coreIdx < nrCores; ++coreIdx)
-					{
-						unsigned int taskSize{ trianglesPerTask };
-						if (remainingTriangles > 0)
-						{
-							++taskSize;
-							--remainingTriangles;
-						}
-						asyncFutures.push_back(
-							std::async(std::launch::async, [=, &verticesRasterSpace, &verticesOut, &indices]
-								{
-									const unsigned int endTriangleIdx{ curTriangleIdx + taskSize * 3 };
-						for (unsigned int triangleIdx{ curTriangleIdx }; triangleIdx < endTriangleIdx; triangleIdx += 3)
+					tileBins[tileX + tileY * m_NrTilesX].push_back(triangleIdx);
+				}
+			}
+		}
+
+		// Weighted blended transparency does not depend on the order of the triangles
+		if (m_TransparencyMode == TransparencyMode::WeightedBlended) return;
+
+		// Blending is not commutative, the transparent triangles of every tile are sorted back to front on the depth of their center
+		auto getCenterDepth = [this](uint32_t triangleIdx)
+			{
+				const RasterTriangle& triangle{ m_Triangles[triangleIdx] };
+				return m_VerticesOut[triangle.vertexIdx0].position.z + m_VerticesOut[triangle.vertexIdx1].position.z + m_VerticesOut[triangle.vertexIdx2].position.z;
+			};
+		for (std::vector<uint32_t>& tileBin : m_TransparentTileBins)
+		{
+			std::stable_sort(tileBin.begin(), tileBin.end(), [&](uint32_t a, uint32_t b) { return getCenterDepth(a) > getCenterDepth(b); });
+		}
+	}
+
+	uint32_t SoftwareRenderer::EncodeRenderModes(const SoftwareMaterial& material) const
+	{
+		// The inverse of DecodeRenderModes
+		uint32_t permutationIdx{ static_cast<uint32_t>(m_LightingMode) };
+		permutationIdx = permutationIdx * 2 + (m_NormalMapActive && material.pNormalTexture);
+		permutationIdx = permutationIdx * 2 + m_ShowDepthBuffer;
+		permutationIdx = permutationIdx * 2 + m_ShowBoundingBox;
+		return permutationIdx * NrCullModes + static_cast<uint32_t>(m_CullMode);
+	}
+
+	template<SoftwareShader Shader, size_t... PermutationIdx>
+	constexpr SoftwareRenderer::ShaderKernels SoftwareRenderer::CreateShaderKernels(std::index_sequence<PermutationIdx...>)
+	{
+		return
+		{
+			&SoftwareRenderer::TransformDrawItem<Shader>,
+			{ &SoftwareRenderer::RenderTriangle<DecodeRenderModes(PermutationIdx), Shader>... },
+			{ &SoftwareRenderer::RenderTriangle<AsTransparent(DecodeRenderModes(PermutationIdx), BlendMode::AlphaBlended), Shader>... },
+			{ &SoftwareRenderer::RenderTriangle<AsTransparent(DecodeRenderModes(PermutationIdx), BlendMode::WeightedBlended), Shader>... },
+			{ &SoftwareRenderer::RenderTriangle<AsDeferred(DecodeRenderModes(PermutationIdx)), Shader>... }
+		};
+	}
+
+	const SoftwareRenderer::ShaderKernels& SoftwareRenderer::GetShaderKernels(uint32_t shaderIdx)
+	{
+		// Every shader in SoftwareShaders gets its vertex stage and a raster and shade kernel for every permutation of the modes
+		static constexpr auto shaderKernels
+		{
+			[]<typename... Shaders>(std::tuple<Shaders...>*)
+			{
+				return std::array<ShaderKernels, sizeof...(Shaders)>{ CreateShaderKernels<Shaders>(std::make_index_sequence<NrRenderModePermutations>{})... };
+			}(static_cast<SoftwareShaders*>(nullptr))
+		};
+		return shaderKernels[shaderIdx];
+	}
+
+	void SoftwareRenderer::RenderTiles(bool useUniformBackground)
+	{
+		const int colorValue{ static_cast<int>((useUniformBackground ? 0.1f : 0.39f) * 255) };
+		const uint32_t clearColor{ SDL_MapRGB(m_pBackBuffer->format, colorValue, colorValue, colorValue) };
+
+		m_DirtyTiles.clear();
+		for (int tileIdx{}; tileIdx < m_NrTilesX * m_NrTilesY; ++tileIdx)
+		{
+			if (m_IsTileDirty[tileIdx]) m_DirtyTiles.push_back(tileIdx);
+		}
+
+		// Every draw item picks the kernel that is specialized for its shader and the current modes once, instead of branching on them for every pixel
+		// The debug views only show the opaque draw items
+		for (DrawItem& drawItem : m_DrawItems)
+		{
+			const ShaderKernels& shaderKernels{ GetShaderKernels(drawItem.pMaterial->shaderIdx) };
+			const uint32_t permutationIdx{ EncodeRenderModes(*drawItem.pMaterial) };
+
+			if (!drawItem.isTransparent) drawItem.pRenderTriangle = IsLightingDeferred() ? shaderKernels.pRenderDeferredTriangles[permutationIdx] : shaderKernels.pRenderTriangles[permutationIdx];
+			else if (m_ShowDepthBuffer || m_ShowBoundingBox) drawItem.pRenderTriangle = nullptr;
+			else if (m_TransparencyMode == TransparencyMode::Sorted) drawItem.pRenderTriangle = shaderKernels.pRenderAlphaBlendedTriangles[permutationIdx];
+			else drawItem.pRenderTriangle = shaderKernels.pRenderWeightedBlendedTriangles[permutationIdx];
+		}
+
+		// Every tile only writes its own pixels, so the tiles can be rendered in any order and on any thread
+		switch (m_ThreadMode)
+		{
+		case dae::ThreadMode::Synchronous:
+			for (int tileIdx : m_DirtyTiles)
+			{
+				RenderTile(tileIdx, clearColor);
+			}
+			break;
+		case dae::ThreadMode::Async:
+		{
+			const size_t nrCores{ std::max(std::thread::hardware_concurrency(), 1u) };
+			const size_t tilesPerTask{ (m_DirtyTiles.size() + nrCores - 1) / nrCores };
+
+			std::vector<std::future<void>> asyncFutures{};
+			for (size_t firstTileIdx{}; firstTileIdx < m_DirtyTiles.size(); firstTileIdx += tilesPerTask)
+			{
+				const size_t endTileIdx{ std::min(firstTileIdx + tilesPerTask, m_DirtyTiles.size()) };
+				asyncFutures.push_back(
+					std::async(std::launch::async, [=, this]
 						{
-							if (triangleIdx + 2 < indices.size()) // Check if indices are within bounds
+							for (size_t tileIdx{ firstTileIdx }; tileIdx < endTileIdx; ++tileIdx)
 							{
-								RenderTriangle(verticesRasterSpace, verticesOut, indices, triangleIdx, false);
+								RenderTile(m_DirtyTiles[tileIdx], clearColor);
 							}
-						}
-								})
-						);
-						curTriangleIdx += taskSize * 3;
-					}
-					for (const std::future<void>& f : asyncFutures)
-					{
-						f.wait();
-					}
-					break;
+						})
+				);
+			}
+			for (const std::future<void>& f : asyncFutures)
+			{
+				f.wait();
+			}
+			break;
+		}
+		case dae::ThreadMode::Parallel:
+			concurrency::parallel_for(0, static_cast<int>(m_DirtyTiles.size()),
+				[&, this](int i)
+				{
+					RenderTile(m_DirtyTiles[i], clearColor);
+				});
+			break;
+		}
+	}
 
-				case dae::ThreadMode::Parallel:
-					concurrency::parallel_for(0, static_cast<int>((indices.size() / 3)),
-						[=, this](int i)
-						{
-							RenderTriangle(verticesRasterSpace, verticesOut, indices, (i * 3), false);
-						});
-					break;
+	void SoftwareRenderer::RenderTile(int tileIdx, uint32_t clearColor) const
+	{
+		const int tileX{ tileIdx % m_NrTilesX };
+		const int tileY{ tileIdx / m_NrTilesX };
+		const ScreenRect tileRect{ tileX * TileSize, tileY * TileSize, std::min((tileX + 1) * TileSize, m_Width), std::min((tileY + 1) * TileSize, m_Height) };
+
+		switch (m_ShadingRate)
+		{
+		case ShadingRate::Rate1x1:
+			RenderTileLayers(tileIdx, tileRect, clearColor, 1);
+			break;
+		case ShadingRate::Rate2x2:
+			RenderTileLayers(tileIdx, tileRect, clearColor, 2);
+			break;
+		case ShadingRate::Rate4x4:
+			RenderTileLayers(tileIdx, tileRect, clearColor, 4);
+			break;
+		case ShadingRate::Adaptive:
+		{
+			// The tile is shaded at the rate its previous result asked for, and shaded again at once when the new result shows more contrast than that rate keeps
+			// Every tile only reads and writes its own block size, so this stays safe on any thread
+			const int shadingBlockSize{ m_pTileShadingBlockSizes[tileIdx] };
+			RenderTileLayers(tileIdx, tileRect, clearColor, shadingBlockSize);
+
+			const int estimatedBlockSize{ EstimateShadingBlockSize(tileRect) };
+			m_pTileShadingBlockSizes[tileIdx] = static_cast<uint8_t>(estimatedBlockSize);
+			if (estimatedBlockSize < shadingBlockSize) RenderTileLayers(tileIdx, tileRect, clearColor, estimatedBlockSize);
+			break;
+		}
+		}
+	}
+
+	void SoftwareRenderer::RenderTileLayers(int tileIdx, const ScreenRect& tileRect, uint32_t clearColor, int shadingBlockSize) const
+	{
+		// Fill the background and reset the depth of the tile
+		for (int py{ tileRect.minY }; py < tileRect.maxY; ++py)
+		{
+			std::fill_n(m_pBackBufferPixels + tileRect.minX + py * m_Width, tileRect.maxX - tileRect.minX, clearColor);
+			std::fill_n(m_pDepthBufferPixels + tileRect.minX + py * m_Width, tileRect.maxX - tileRect.minX, FLT_MAX);
+		}
+
+		// The G-buffer of the tile starts without surfaces, the background keeps its color
+		const bool isLightingDeferred{ IsLightingDeferred() };
+		if (isLightingDeferred)
+		{
+			for (int py{ tileRect.minY }; py < tileRect.maxY; ++py)
+			{
+				for (int px{ tileRect.minX }; px < tileRect.maxX; ++px)
+				{
+					m_pGBuffer[px + py * m_Width].surfaceType = SurfaceType::None;
 				}
-				break;
-			case PrimitiveTopology::TriangleStrip:
-				// For each triangle
-				switch (m_ThreadMode)
+			}
+		}
+
+		for (uint32_t triangleIdx : m_TileBins[tileIdx])
+		{
+			const RasterTriangle& triangle{ m_Triangles[triangleIdx] };
+			(this->*m_DrawItems[triangle.drawItemIdx].pRenderTriangle)(triangle, tileRect, shadingBlockSize);
+		}
+
+		// Light the visible surfaces before the transparent triangles are blended over them
+		if (isLightingDeferred) LightTile(tileIdx, tileRect);
+
+		const std::vector<uint32_t>& transparentTileBin{ m_TransparentTileBins[tileIdx] };
+		if (transparentTileBin.empty()) return;
+
+		// Nothing is accumulated yet in the pixels of the tile, and everything behind them is still visible
+		const bool isWeightedBlended{ m_TransparencyMode == TransparencyMode::WeightedBlended };
+		if (isWeightedBlended)
+		{
+			for (int py{ tileRect.minY }; py < tileRect.maxY; ++py)
+			{
+				std::fill_n(m_pAccumulationPixels + (tileRect.minX + py * m_Width) * 4, (tileRect.maxX - tileRect.minX) * 4, 0.0f);
+				std::fill_n(m_pRevealagePixels + tileRect.minX + py * m_Width, tileRect.maxX - tileRect.minX, 1.0f);
+			}
+		}
+
+		// Blend or accumulate the transparent triangles over the finished opaque pixels of the tile
+		for (uint32_t triangleIdx : transparentTileBin)
+		{
+			const RasterTriangle& triangle{ m_Triangles[triangleIdx] };
+			const RenderTriangleFunction pRenderTriangle{ m_DrawItems[triangle.drawItemIdx].pRenderTriangle };
+			if (pRenderTriangle) (this->*pRenderTriangle)(triangle, tileRect, 1);
+		}
+
+		if (isWeightedBlended) CompositeWeightedBlended(tileRect);
+	}
+
+	int SoftwareRenderer::EstimateShadingBlockSize(const ScreenRect& tileRect) const
+	{
+		// The average luminance difference between neighbouring blocks above which a block size loses visible detail
+		constexpr float MaxContrast4x4{ 0.02f };
+		constexpr float MaxContrast2x2{ 0.06f };
+
+		// Only the top left pixel of the largest blocks is compared, every shading rate shades it when it is covered
+		const SDL_PixelFormat* pFormat{ m_pBackBuffer->format };
+		auto getLuminance = [&](int px, int py)
+			{
+				Uint8 r{};
+				Uint8 g{};
+				Uint8 b{};
+				SDL_GetRGB(m_pBackBufferPixels[px + py * m_Width], pFormat, &r, &g, &b);
+				return (0.2126f * r + 0.7152f * g + 0.0722f * b) / 255.0f;
+			};
+
+		float totalContrast{};
+		int nrComparisons{};
+		for (int py{ tileRect.minY }; py < tileRect.maxY; py += MaxShadingBlockSize)
+		{
+			for (int px{ tileRect.minX }; px < tileRect.maxX; px += MaxShadingBlockSize)
+			{
+				const float luminance{ getLuminance(px, py) };
+				if (px + MaxShadingBlockSize < tileRect.maxX)
 				{
-				case dae::ThreadMode::Synchronous:
-					for (int curStartVertexIdx = 0; curStartVertexIdx < indices.size() - 2; ++curStartVertexIdx)
-					{
-						RenderTriangle(verticesRasterSpace, verticesOut, indices, curStartVertexIdx, curStartVertexIdx % 2);
-					}
-					break;
-				case dae::ThreadMode::Async:
-					trianglesPerTask = (indices.size() - 2) / nrCores;
-					remainingTriangles = (indices.size() - 2) % nrCores;
-					curTriangleIdx = 0; // Initialize curTriangleIdx
-					for (unsigned int coreIdx = 0; coreIdx < nrCores; ++coreIdx)
+					totalContrast += abs(getLuminance(px + MaxShadingBlockSize, py) - luminance);
+					++nrComparisons;
+				}
+				if (py + MaxShadingBlockSize < tileRect.maxY)
+				{
+					totalContrast += abs(getLuminance(px, py + MaxShadingBlockSize) - luminance);
+					++nrComparisons;
+				}
+			}
+		}
+
+		// Tiles at the edge of the screen can be too small to compare anything
+		if (nrComparisons == 0) return 1;
+
+		const float averageContrast{ totalContrast / nrComparisons };
+		if (averageContrast > MaxContrast2x2) return 1;
+		if (averageContrast > MaxContrast4x4) return 2;
+		return MaxShadingBlockSize;
+	}
+
+	template<SoftwareRenderer::RenderModes Modes, SoftwareShader Shader>
+	void dae::SoftwareRenderer::RenderTriangle(const RasterTriangle& triangle, const ScreenRect& tileRect, int shadingBlockSize) const
+	{
+		const std::vector<Vertex_Out>& verticesOut{ m_VerticesOut };
+		const SoftwareMaterial& material{ *m_DrawItems[triangle.drawItemIdx].pMaterial };
+
+		// Only the attributes the shading of these modes reads are interpolated
+		constexpr Varyings varyings{ GetRequiredVaryings<Shader>(Modes) };
+		constexpr bool isOpaque{ Modes.blendMode == BlendMode::Opaque || Modes.blendMode == BlendMode::GBuffer };
+
+		// The indexes of the vertices on this triangle, degenerate and clipped triangles were already rejected during setup
+		const uint32_t vertexIdx0{ triangle.vertexIdx0 };
+		const uint32_t vertexIdx1{ triangle.vertexIdx1 };
+		const uint32_t vertexIdx2{ triangle.vertexIdx2 };
+	
+		// Get all the current vertices
+		const Vector2 v0{ m_VerticesRasterSpace[vertexIdx0] };
+		const Vector2 v1{ m_VerticesRasterSpace[vertexIdx1] };
+		const Vector2 v2{ m_VerticesRasterSpace[vertexIdx2] };
+	
+		// Calculate the edges of the current triangle
+		const Vector2 edge01{ v1 - v0 };
+		const Vector2 edge12{ v2 - v1 };
+		const Vector2 edge20{ v0 - v2 };
+	
+		// Calculate the area of the current triangle
+		const float fullTriangleArea{ Vector2::Cross(edge01, edge12) };
+		const float inverseTriangleArea{ 1.0f / fullTriangleArea };
+
+		// Divide the depth and the used attributes by the depth once per vertex instead of for every pixel
+		const Vertex_Out* pVertices[3]{ &verticesOut[vertexIdx0], &verticesOut[vertexIdx1], &verticesOut[vertexIdx2] };
+		float inverseZ[3]{};
+		float inverseW[3]{};
+		Vector2 uvOverW[3]{};
+		Vector3 normalOverW[3]{};
+		Vector3 tangentOverW[3]{};
+		Vector3 viewDirectionOverW[3]{};
+		for (int cornerIdx{}; cornerIdx < 3; ++cornerIdx)
+		{
+			const Vertex_Out& vertex{ *pVertices[cornerIdx] };
+			inverseZ[cornerIdx] = 1.0f / vertex.position.z;
+			inverseW[cornerIdx] = 1.0f / vertex.position.w;
+			if constexpr (varyings.uv) uvOverW[cornerIdx] = vertex.uv * inverseW[cornerIdx];
+			if constexpr (varyings.normal) normalOverW[cornerIdx] = vertex.normal * inverseW[cornerIdx];
+			if constexpr (varyings.tangent) tangentOverW[cornerIdx] = vertex.tangent * inverseW[cornerIdx];
+			if constexpr (varyings.viewDirection) viewDirectionOverW[cornerIdx] = vertex.viewDirection * inverseW[cornerIdx];
+		}
+	
+		// Calculate the bounding box of this triangle
+		Vector2 minBoundingBox{ Vector2::Min(v0, Vector2::Min(v1, v2)) };
+		Vector2 maxBoundingBox{ Vector2::Max(v0, Vector2::Max(v1, v2)) };
+	
+		// A margin that enlarges the bounding box, makes sure that some pixels do no get ignored
+		const int margin{ 1 };
+	
+		// Calculate the start and end pixel bounds of this triangle, only inside the tile that is rendered
+		const int startX{ std::max(static_cast<int>(minBoundingBox.x - margin), tileRect.minX) };
+		const int startY{ std::max(static_cast<int>(minBoundingBox.y - margin), tileRect.minY) };
+		const int endX{ std::min(static_cast<int>(maxBoundingBox.x + margin), tileRect.maxX) };
+		const int endY{ std::min(static_cast<int>(maxBoundingBox.y + margin), tileRect.maxY) };
+
+		// Only fill the bounding box, without testing the pixels
+		if constexpr (Modes.showBoundingBox)
+		{
+			const uint32_t boundingBoxColor{ SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255) };
+			for (int py = startY; py < endY; ++py)
+			{
+				if (startX < endX) std::fill_n(m_pBackBufferPixels + startX + py * m_Width, endX - startX, boundingBoxColor);
+			}
+			return;
+		}
+	
+		// Tests if the pixel is inside the triangle and in front of the depth buffer, and finds its barycentric weights and Z depth
+		auto rasterizePixel = [&](int px, int py, float (&weights)[3], float& interpolatedZDepth)
+			{
+				const int pixelIdx{ px + py * m_Width };
+				const Vector2 curPixel(static_cast<float>(px), static_cast<float>(py));
+
+				const Vector2 v0ToPoint = curPixel - v0;
+				const Vector2 v1ToPoint = curPixel - v1;
+				const Vector2 v2ToPoint = curPixel - v2;
+
+				float edge01PointCross = Vector2::Cross(edge01, v0ToPoint);
+				float edge12PointCross = Vector2::Cross(edge12, v1ToPoint);
+				float edge20PointCross = Vector2::Cross(edge20, v2ToPoint);
+
+				const bool isFrontFaceHit = edge01PointCross >= 0 && edge12PointCross >= 0 && edge20PointCross >= 0;
+				const bool isBackFaceHit = edge01PointCross <= 0 && edge12PointCross <= 0 && edge20PointCross <= 0;
+
+				if constexpr (Modes.cullMode == CullMode::Back)
+				{
+					if (!isFrontFaceHit) return false;
+				}
+				else if constexpr (Modes.cullMode == CullMode::Front)
+				{
+					if (!isBackFaceHit) return false;
+				}
+				else
+				{
+					if (!isBackFaceHit && !isFrontFaceHit) return false;
+				}
+
+				// Calculate the barycentric weights
+				weights[0] = edge12PointCross * inverseTriangleArea;
+				weights[1] = edge20PointCross * inverseTriangleArea;
+				weights[2] = edge01PointCross * inverseTriangleArea;
+
+				// Calculate the Z depth at this pixel
+				interpolatedZDepth = 1.0f / (weights[0] * inverseZ[0] + weights[1] * inverseZ[1] + weights[2] * inverseZ[2]);
+
+				// If the depth is outside the frustum, or if the current depth buffer is less than the current depth, continue to the next pixel
+				if (m_pDepthBufferPixels[pixelIdx] < interpolatedZDepth) return false;
+
+				// Save the new depth, transparent triangles are tested against the depth but do not hide what is behind them
+				if constexpr (isOpaque) m_pDepthBufferPixels[pixelIdx] = interpolatedZDepth;
+
+				// The G-buffer keeps the view depth of every pixel, also when its shading is shared with a block
+				if constexpr (Modes.blendMode == BlendMode::GBuffer)
+				{
+					m_pGBuffer[pixelIdx].depth = 1.0f / (weights[0] * inverseW[0] + weights[1] * inverseW[1] + weights[2] * inverseW[2]);
+				}
+				return true;
+			};
+
+		// Interpolates the attributes the shading reads at a pixel
+		auto interpolatePixel = [&](const float (&weights)[3], float interpolatedZDepth, Vertex_Out& pixelInfo)
+			{
+				const float weightV0{ weights[0] };
+				const float weightV1{ weights[1] };
+				const float weightV2{ weights[2] };
+
+				if constexpr (Modes.showDepthBuffer)
+				{
+					// Remap the Z depth
+					float depthColor = Remap(interpolatedZDepth, 0.997f, 1.0f);
+
+					// Set the color of the current pixel to showcase the depth
+					pixelInfo.color = { depthColor, depthColor, depthColor };
+				}
+
+				// The weight of an accumulated pixel depends on its view depth
+				if constexpr (Modes.blendMode == BlendMode::WeightedBlended)
+				{
+					pixelInfo.position.w = 1.0f / (weightV0 * inverseW[0] + weightV1 * inverseW[1] + weightV2 * inverseW[2]);
+				}
+
+				// Calculate the UV coordinate at this pixel, it is the only attribute that needs the W depth
+				if constexpr (varyings.uv)
+				{
+					const float interpolatedWDepth{ 1.0f / (weightV0 * inverseW[0] + weightV1 * inverseW[1] + weightV2 * inverseW[2]) };
+					pixelInfo.uv = (weightV0 * uvOverW[0] + weightV1 * uvOverW[1] + weightV2 * uvOverW[2]) * interpolatedWDepth;
+				}
+
+				// The directions are normalized, so multiplying them with the W depth would not change them
+				// Calculate the normal at this pixel
+				if constexpr (varyings.normal)
+				{
+					pixelInfo.normal = (weightV0 * normalOverW[0] + weightV1 * normalOverW[1] + weightV2 * normalOverW[2]).Normalized();
+				}
+
+				// Calculate the tangent at this pixel
+				if constexpr (varyings.tangent)
+				{
+					pixelInfo.tangent = (weightV0 * tangentOverW[0] + weightV1 * tangentOverW[1] + weightV2 * tangentOverW[2]).Normalized();
+				}
+
+				// Calculate the view direction at this pixel
+				if constexpr (varyings.viewDirection)
+				{
+					pixelInfo.viewDirection = (weightV0 * viewDirectionOverW[0] + weightV1 * viewDirectionOverW[1] + weightV2 * viewDirectionOverW[2]).Normalized();
+				}
+			};
+
+		// The pixels that passed the depth test are collected and shaded per packet
+		PixelPacket packet{};
+		float weights[3]{};
+		float interpolatedZDepth{};
+
+		// Opaque pixels can share their shading with the other pixels of their block, blended pixels and the depth view are always shaded per pixel
+		if constexpr (isOpaque && !Modes.showDepthBuffer)
+		{
+			if (shadingBlockSize > 1)
+			{
+				packet.shadingBlockSize = shadingBlockSize;
+
+				// The blocks are aligned to the tile
+				const int startBlockX{ startX - (startX - tileRect.minX) % shadingBlockSize };
+				const int startBlockY{ startY - (startY - tileRect.minY) % shadingBlockSize };
+
+				for (int blockY{ startBlockY }; blockY < endY; blockY += shadingBlockSize)
+				{
+					for (int blockX{ startBlockX }; blockX < endX; blockX += shadingBlockSize)
 					{
-						unsigned int taskSize{ trianglesPerTask };
-						if (remainingTriangles > 0)
-						{
-							++taskSize;
-							--remainingTriangles;
-						}
-						asyncFutures.push_back(
-							std::async(std::launch::async, [=, &verticesRasterSpace, &verticesOut, &indices]
-								{
-									const unsigned int endTriangleIdx{ curTriangleIdx + taskSize };
-						for (unsigned int triangleIdx{ curTriangleIdx }; triangleIdx < endTriangleIdx; ++triangleIdx)
+						Vertex_Out& pixelInfo{ packet.pixelInfo[packet.count] };
+						uint16_t coverageMask{};
+
+						// Depth and coverage are still tested for every pixel of the block
+						for (int py{ std::max(blockY, startY) }; py < std::min(blockY + shadingBlockSize, endY); ++py)
 						{
-							if (triangleIdx + 2 < indices.size()) // Check if indices are within bounds
+							for (int px{ std::max(blockX, startX) }; px < std::min(blockX + shadingBlockSize, endX); ++px)
 							{
-								RenderTriangle(verticesRasterSpace, verticesOut, indices, triangleIdx, triangleIdx % 2);
+								if (!rasterizePixel(px, py, weights, interpolatedZDepth)) continue;
+
+								// The block is shaded with the attributes of its first covered pixel, so they are never extrapolated outside the triangle
+								if (coverageMask == 0) interpolatePixel(weights, interpolatedZDepth, pixelInfo);
+								coverageMask |= static_cast<uint16_t>(1 << ((px - blockX) + (py - blockY) * shadingBlockSize));
 							}
 						}
-								})
-						);
-						curTriangleIdx += taskSize;
+
+						if (coverageMask == 0) continue;
+						packet.pixelIdx[packet.count] = blockX + blockY * m_Width;
+						packet.coverageMask[packet.count] = coverageMask;
+
+						// Calculate the shading of the blocks and display them on screen once the packet is full
+						if (++packet.count == PacketSize)
+						{
+							PixelShading<Modes, Shader>(packet, material);
+							packet.count = 0;
+						}
 					}
-					for (const std::future<void>& f : asyncFutures)
+				}
+
+				// Shade the blocks that are left
+				if (packet.count > 0) PixelShading<Modes, Shader>(packet, material);
+				return;
+			}
+		}
+
+		for (int py = startY; py < endY; ++py)
+		{
+			for (int px = startX; px < endX; ++px)
+			{
+				if (!rasterizePixel(px, py, weights, interpolatedZDepth)) continue;
+
+				// The pixel info, stored in the next lane of the packet
+				interpolatePixel(weights, interpolatedZDepth, packet.pixelInfo[packet.count]);
+				packet.pixelIdx[packet.count] = px + py * m_Width;
+
+				// Calculate the shading of the pixels and display them on screen once the packet is full
+				if (++packet.count == PacketSize)
+				{
+					PixelShading<Modes, Shader>(packet, material);
+					packet.count = 0;
+				}
+			}
+		}
+
+		// Shade the pixels that are left
+		if (packet.count > 0) PixelShading<Modes, Shader>(packet, material);
+	}
+#pragma region testing
+
+#pragma endregion
+
+	void SoftwareRenderer::ResetDepthBuffer() const
+	{
+		// The nr of pixels in the buffer
+		const int nrPixels{ m_Width * m_Height };
+
+		// Set everything in the depth buffer to the value FLT_MAX
+		std::fill_n(m_pDepthBufferPixels, nrPixels, FLT_MAX);
+	}
+
+	template<SoftwareRenderer::RenderModes Modes, SoftwareShader Shader>
+	void SoftwareRenderer::PixelShading(const PixelPacket& packet, const SoftwareMaterial& material) const
+	{
+		// The lanes after the last pixel repeat the first one, so every lane holds valid values
+		const PixelShaderInput input
+		{
+			{ &packet.pixelInfo[0], &packet.pixelInfo[packet.count > 1 ? 1 : 0], &packet.pixelInfo[packet.count > 2 ? 2 : 0], &packet.pixelInfo[packet.count > 3 ? 3 : 0] },
+			&material,
+			&m_PowLookupTable,
+			m_SpecularPowMode
+		};
+
+		// Write the surface to the G-buffer, the lighting pass colors it
+		if constexpr (Modes.blendMode == BlendMode::GBuffer)
+		{
+			alignas(16) uint32_t diffuseColors[PacketSize];
+			alignas(16) uint32_t specularColors[PacketSize];
+			alignas(16) float exponents[PacketSize]{};
+			alignas(16) float normalsX[PacketSize]{};
+			alignas(16) float normalsY[PacketSize]{};
+			alignas(16) float normalsZ[PacketSize]{};
+			SurfaceType surfaceType{};
+
+			if constexpr (DeferredSoftwareShader<Shader>)
+			{
+				const SurfacePacket surface{ Shader::template ShadeSurface<Modes.shading>(input) };
+				_mm_store_si128(reinterpret_cast<__m128i*>(diffuseColors), PackColors(surface.diffuse));
+				_mm_store_si128(reinterpret_cast<__m128i*>(specularColors), PackColors(surface.specular));
+				_mm_store_ps(exponents, surface.exponent);
+				_mm_store_ps(normalsX, surface.normal.x);
+				_mm_store_ps(normalsY, surface.normal.y);
+				_mm_store_ps(normalsZ, surface.normal.z);
+				surfaceType = SurfaceType::Lit;
+			}
+			else
+			{
+				// Shaders without a surface color the pixels themselves
+				ColorRGBPacket color{ Shader::template ShadePixels<Modes.shading>(input) };
+				color.MaxToOne();
+				_mm_store_si128(reinterpret_cast<__m128i*>(diffuseColors), PackColors(color));
+				std::fill_n(specularColors, PacketSize, 0u);
+				surfaceType = SurfaceType::Unlit;
+			}
+
+			for (int laneIdx{}; laneIdx < packet.count; ++laneIdx)
+			{
+				ForEachCoveredPixel(packet, laneIdx, [&](int pixelIdx)
 					{
-						f.wait();
-					}
-					break;
+						GBufferTexel& texel{ m_pGBuffer[pixelIdx] };
+						texel.normal = { normalsX[laneIdx], normalsY[laneIdx], normalsZ[laneIdx] };
+						texel.diffuse = diffuseColors[laneIdx];
+						texel.specular = specularColors[laneIdx];
+						texel.exponent = exponents[laneIdx];
+						texel.surfaceType = surfaceType;
+					});
+			}
+			return;
+		}
 
-				case dae::ThreadMode::Parallel:
-					concurrency::parallel_for(0, static_cast<int>((indices.size() - 2)),
-						[=, this](int i)
-						{
-							RenderTriangle(verticesRasterSpace, verticesOut, indices, i, i % 2);
-						});
-					break;
-				}
-				break;
+		// The final color that will be rendered
+		ColorRGBPacket finalColor{};
+
+		// Depending on the rendering state, do other things
+		if constexpr (Modes.showDepthBuffer)
+		{
+			// Only render the depth which is saved in the color attribute of the pixel info
+			finalColor = ColorRGBPacket::FromLanes(input.pPixels[0]->color, input.pPixels[1]->color, input.pPixels[2]->color, input.pPixels[3]->color);
+		}
+		else
+		{
+			// The shader of the material colors the pixels
+			finalColor = Shader::template ShadePixels<Modes.shading>(input);
+		}
+
+		//Update Color in Buffer
+		finalColor.MaxToOne();
+
+		// Add the pixels to the weighted sums of the tile, they are blended over the buffer by CompositeWeightedBlended
+		if constexpr (Modes.blendMode == BlendMode::WeightedBlended)
+		{
+			const __m128 alpha{ input.SampleAlpha(material.pDiffuseTexture) };
+
+			// Closer pixels weigh more, so they dominate the average color (McGuire and Bavoil, equation 10)
+			const __m128 viewDepth{ _mm_setr_ps(input.pPixels[0]->position.w, input.pPixels[1]->position.w, input.pPixels[2]->position.w, input.pPixels[3]->position.w) };
+			const __m128 nearTerm{ _mm_mul_ps(viewDepth, _mm_set1_ps(1.0f / 5.0f)) };
+			const __m128 farTerm{ _mm_mul_ps(viewDepth, _mm_set1_ps(1.0f / 200.0f)) };
+			const __m128 farTermCubed{ _mm_mul_ps(farTerm, _mm_mul_ps(farTerm, farTerm)) };
+			const __m128 depthFalloff{ _mm_add_ps(_mm_set1_ps(1e-5f), _mm_add_ps(_mm_mul_ps(nearTerm, nearTerm), _mm_mul_ps(farTermCubed, farTermCubed))) };
+			const __m128 weight{ _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_set1_ps(10.0f), depthFalloff), _mm_set1_ps(1e-2f)), _mm_set1_ps(3e3f)) };
+			const __m128 alphaWeight{ _mm_mul_ps(alpha, weight) };
+
+			// Turn the channels of the packet into one premultiplied color per pixel
+			__m128 pixel0{ _mm_mul_ps(finalColor.r, alphaWeight) };
+			__m128 pixel1{ _mm_mul_ps(finalColor.g, alphaWeight) };
+			__m128 pixel2{ _mm_mul_ps(finalColor.b, alphaWeight) };
+			__m128 pixel3{ alphaWeight };
+			_MM_TRANSPOSE4_PS(pixel0, pixel1, pixel2, pixel3);
+			const __m128 pixels[PacketSize]{ pixel0, pixel1, pixel2, pixel3 };
+
+			alignas(16) float inverseAlphas[PacketSize];
+			_mm_store_ps(inverseAlphas, _mm_sub_ps(_mm_set1_ps(1.0f), alpha));
+
+			for (int laneIdx{}; laneIdx < packet.count; ++laneIdx)
+			{
+				float* pAccumulation{ m_pAccumulationPixels + packet.pixelIdx[laneIdx] * 4 };
+				_mm_storeu_ps(pAccumulation, _mm_add_ps(_mm_loadu_ps(pAccumulation), pixels[laneIdx]));
+				m_pRevealagePixels[packet.pixelIdx[laneIdx]] *= inverseAlphas[laneIdx];
 			}
+			return;
 		}
-		
-		if (m_ThreadModeChange)
+
+		// Blend with the colors in the buffer as SRC_ALPHA * source + INV_SRC_ALPHA * destination
+		if constexpr (Modes.blendMode == BlendMode::AlphaBlended)
 		{
-			m_ThreadMode = m_NextMode;
-			m_ThreadModeChange = false;
+			const __m128 alpha{ input.SampleAlpha(material.pDiffuseTexture) };
+			const __m128 inverseAlpha{ _mm_sub_ps(_mm_set1_ps(1.0f), alpha) };
+			finalColor = finalColor * alpha + ReadBackBuffer(packet) * inverseAlpha;
 		}
 
-		//Update SDL Surface
-		SDL_UnlockSurface(m_pBackBuffer);
-		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-		SDL_UpdateWindowSurface(m_pWindow);
-	}
+		alignas(16) float red[PacketSize];
+		alignas(16) float green[PacketSize];
+		alignas(16) float blue[PacketSize];
+		_mm_store_ps(red, finalColor.r);
+		_mm_store_ps(green, finalColor.g);
+		_mm_store_ps(blue, finalColor.b);
 
-	void SoftwareRenderer::SetTextures(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture)
-	{
-		m_pDiffuseTexture = pDiffuseTexture;
-		m_pNormalTexture = pNormalTexture;
-		m_pSpecularTexture = pSpecularTexture;
-		m_pGlossinessTexture = pGlossinessTexture;
-	}
+		for (int laneIdx{}; laneIdx < packet.count; ++laneIdx)
+		{
+			const uint32_t color{ SDL_MapRGB(m_pBackBuffer->format,
+				static_cast<uint8_t>(red[laneIdx] * 255),
+				static_cast<uint8_t>(green[laneIdx] * 255),
+				static_cast<uint8_t>(blue[laneIdx] * 255)) };
 
-	void SoftwareRenderer::SetMesh(Mesh* pMesh)
-	{
-		// Set the current mesh that should be displayed
-		m_pMesh = pMesh;
+			ForEachCoveredPixel(packet, laneIdx, [&](int pixelIdx) { m_pBackBufferPixels[pixelIdx] = color; });
+		}
 	}
 
-	void SoftwareRenderer::SetCulling(CullMode cullMode)
+	template<typename PixelFunction>
+	void SoftwareRenderer::ForEachCoveredPixel(const PixelPacket& packet, int laneIdx, PixelFunction pixelFunction) const
 	{
-		m_CullMode = cullMode;
+		if (packet.shadingBlockSize == 1)
+		{
+			pixelFunction(packet.pixelIdx[laneIdx]);
+			return;
+		}
+
+		// A coarse lane covers the pixels of its block that are set in its mask
+		for (uint32_t coverageMask{ packet.coverageMask[laneIdx] }; coverageMask != 0; coverageMask &= coverageMask - 1)
+		{
+			const int blockPixelIdx{ std::countr_zero(coverageMask) };
+			pixelFunction(packet.pixelIdx[laneIdx] + blockPixelIdx % packet.shadingBlockSize + blockPixelIdx / packet.shadingBlockSize * m_Width);
+		}
 	}
 
-	void dae::SoftwareRenderer::VertexTransformationFunction(std::vector<Vertex_Out>& verticesOut, const std::unique_ptr<Camera>& pCamera)
+	ColorRGBPacket SoftwareRenderer::ReadBackBuffer(const PixelPacket& packet) const
 	{
-		// Retrieve the world matrix of the current mesh
-		Matrix& worldMatrix{ m_pMesh->GetWorldMatrix() };
-		std::vector<Vertex> vertices{ m_pMesh->GetVertices() };
+		// The lanes after the last pixel repeat the first one
+		const __m128i pixels
+		{
+			_mm_setr_epi32(
+				m_pBackBufferPixels[packet.pixelIdx[0]],
+				m_pBackBufferPixels[packet.pixelIdx[packet.count > 1 ? 1 : 0]],
+				m_pBackBufferPixels[packet.pixelIdx[packet.count > 2 ? 2 : 0]],
+				m_pBackBufferPixels[packet.pixelIdx[packet.count > 3 ? 3 : 0]])
+		};
+
+		// Shift every channel of the 8-bit format down and convert it to [0, 1]
+		const SDL_PixelFormat* pFormat{ m_pBackBuffer->format };
+		auto unpackChannel = [&](Uint8 shift)
+			{
+				const __m128i channel{ _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF)) };
+				return _mm_mul_ps(_mm_cvtepi32_ps(channel), _mm_set1_ps(1.0f / 255.0f));
+			};
 
-		// Calculate the transformation matrix for this mesh
-		Matrix worldViewProjectionMatrix{ worldMatrix * pCamera->GetViewMatrix() * pCamera->GetProjectionMatrix() };
+		return ColorRGBPacket{ unpackChannel(pFormat->Rshift), unpackChannel(pFormat->Gshift), unpackChannel(pFormat->Bshift) };
+	}
 
-		// Reserve the amount of vertices into the new vertex list
-		verticesOut.reserve(vertices.size());
+	void SoftwareRenderer::CompositeWeightedBlended(const ScreenRect& tileRect) const
+	{
+		const SDL_PixelFormat* pFormat{ m_pBackBuffer->format };
+		const __m128 minAlpha{ _mm_set1_ps(1e-5f) };
 
-		// For each vertex in the mesh
-		for (const Vertex& v : vertices)
+		for (int py{ tileRect.minY }; py < tileRect.maxY; ++py)
 		{
-			// Create a new vertex	
-			Vertex_Out vOut{ {}, v.normal, v.tangent, v.uv, v.color };
+			for (int px{ tileRect.minX }; px < tileRect.maxX; ++px)
+			{
+				const int pixelIdx{ px + py * m_Width };
+
+				// Pixels without transparent triangles keep their color
+				const float revealage{ m_pRevealagePixels[pixelIdx] };
+				if (revealage >= 1.0f) continue;
+
+				// The weighted average color of the transparent pixels, the sum of the weighted alphas is in the last channel
+				const __m128 accumulation{ _mm_loadu_ps(m_pAccumulationPixels + pixelIdx * 4) };
+				const __m128 averageColor{ _mm_div_ps(accumulation, _mm_max_ps(_mm_shuffle_ps(accumulation, accumulation, _MM_SHUFFLE(3, 3, 3, 3)), minAlpha)) };
+
+				Uint8 r{};
+				Uint8 g{};
+				Uint8 b{};
+				SDL_GetRGB(m_pBackBufferPixels[pixelIdx], pFormat, &r, &g, &b);
+				const __m128 destinationColor{ _mm_mul_ps(_mm_setr_ps(r, g, b, 0.0f), _mm_set1_ps(1.0f / 255.0f)) };
+
+				// The revealage is how much of the color behind the transparent pixels is still visible
+				const __m128 color{ _mm_add_ps(_mm_mul_ps(averageColor, _mm_set1_ps(1.0f - revealage)), _mm_mul_ps(destinationColor, _mm_set1_ps(revealage))) };
+
+				alignas(16) float channels[4];
+				_mm_store_ps(channels, color);
+				m_pBackBufferPixels[pixelIdx] = SDL_MapRGB(pFormat,
+					static_cast<uint8_t>(channels[0] * 255),
+					static_cast<uint8_t>(channels[1] * 255),
+					static_cast<uint8_t>(channels[2] * 255));
+			}
+		}
+	}
 
-			// Tranform the vertex using the inversed view matrix
-			vOut.position = worldViewProjectionMatrix.TransformPoint({ v.position, 1.0f });
+	__m128i SoftwareRenderer::PackColors(const ColorRGBPacket& colors)
+	{
+		// Every lane gets 8 bits per channel, with red in the lowest byte
+		auto packChannel = [](__m128 channel)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(channel, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f)));
+			};
 
-			// Calculate the view direction
-			vOut.viewDirection = Vector3{ vOut.position.x, vOut.position.y, vOut.position.z };
-			vOut.viewDirection.Normalize();
+		return _mm_or_si128(packChannel(colors.r), _mm_or_si128(_mm_slli_epi32(packChannel(colors.g), 8), _mm_slli_epi32(packChannel(colors.b), 16)));
+	}
 
-			// Divide all properties of the position by the original z (stored in position.w)
-			vOut.position.x /= vOut.position.w;
-			vOut.position.y /= vOut.position.w;
-			vOut.position.z /= vOut.position.w;
+	ColorRGBPacket SoftwareRenderer::UnpackColors(__m128i packedColors)
+	{
+		auto unpackChannel = [&](int shift)
+			{
+				const __m128i channel{ _mm_and_si128(_mm_srli_epi32(packedColors, shift), _mm_set1_epi32(0xFF)) };
+				return _mm_mul_ps(_mm_cvtepi32_ps(channel), _mm_set1_ps(1.0f / 255.0f));
+			};
 
-			// Transform the normal and the tangent of the vertex
-			vOut.normal = worldMatrix.TransformVector(v.normal);
-			vOut.tangent = worldMatrix.TransformVector(v.tangent);
+		return ColorRGBPacket{ unpackChannel(0), unpackChannel(8), unpackChannel(16) };
+	}
 
-			// Add the new vertex to the list of NDC vertices
-			verticesOut.emplace_back(vOut);
-		}
+	bool SoftwareRenderer::IsLightingDeferred() const
+	{
+		// The depth buffer and bounding box views show the forward rendered scene
+		return m_IsDeferredLighting && !m_ShowDepthBuffer && !m_ShowBoundingBox;
 	}
 
-	void dae::SoftwareRenderer::RenderTriangle(const std::vector<Vector2>& rasterVertices, const std::vector<Vertex_Out>& verticesOut, const std::vector<uint32_t>& indices, int curVertexIdx, bool swapVertices) const
+	void SoftwareRenderer::BinPointLights()
 	{
-		// Calcalate the indexes of the vertices on this triangle
-		const uint32_t vertexIdx0{ indices[static_cast<uint32_t>(curVertexIdx)] };
-		const uint32_t vertexIdx1{ indices[static_cast<uint32_t>(curVertexIdx + 1 * !swapVertices + 2 * swapVertices)] };
-		const uint32_t vertexIdx2{ indices[static_cast<uint32_t>(curVertexIdx + 2 * !swapVertices + 1 * swapVertices)] };
-	
-		// If a triangle has the same vertex twice
-		// Or if a one of the vertices is outside the frustum
-		// Continue
-		if (vertexIdx0 == vertexIdx1 || vertexIdx1 == vertexIdx2 || vertexIdx0 == vertexIdx2 ||
-			IsOutsideFrustum(verticesOut[vertexIdx0].position) ||
-			IsOutsideFrustum(verticesOut[vertexIdx1].position) ||
-			IsOutsideFrustum(verticesOut[vertexIdx2].position))
-			return;
-	
-		// Get all the current vertices
-		const Vector2 v0{ rasterVertices[vertexIdx0] };
-		const Vector2 v1{ rasterVertices[vertexIdx1] };
-		const Vector2 v2{ rasterVertices[vertexIdx2] };
-	
-		// Calculate the edges of the current triangle
-		const Vector2 edge01{ v1 - v0 };
-		const Vector2 edge12{ v2 - v1 };
-		const Vector2 edge20{ v0 - v2 };
-	
-		// Calculate the area of the current triangle
-		const float fullTriangleArea{ Vector2::Cross(edge01, edge12) };
-	
-		// If the triangle area is 0 or NaN, continue to the next triangle
-		if (abs(fullTriangleArea) < FLT_EPSILON || isnan(fullTriangleArea)) return;
-	
-		// Calculate the bounding box of this triangle
-		Vector2 minBoundingBox{ Vector2::Min(v0, Vector2::Min(v1, v2)) };
-		Vector2 maxBoundingBox{ Vector2::Max(v0, Vector2::Max(v1, v2)) };
-	
-		// A margin that enlarges the bounding box, makes sure that some pixels do no get ignored
-		const int margin{ 1 };
-	
-		// Calculate the start and end pixel bounds of this triangle
-		const int startX{ std::max(static_cast<int>(minBoundingBox.x - margin), 0) };
-		const int startY{ std::max(static_cast<int>(minBoundingBox.y - margin), 0) };
-		const int endX{ std::min(static_cast<int>(maxBoundingBox.x + margin), m_Width) };
-		const int endY{ std::min(static_cast<int>(maxBoundingBox.y + margin), m_Height) };
-	
-		for (int py = startY; py < endY; ++py)
+		for (std::vector<uint32_t>& tileLights : m_TileLights)
 		{
-			for (int px = startX; px < endX; ++px)
+			tileLights.clear();
+		}
+
+		// Add every light to the tiles the screen rectangle of its sphere overlaps
+		for (uint32_t lightIdx{}; lightIdx < m_PointLights.size(); ++lightIdx)
+		{
+			const SoftwarePointLight& light{ m_PointLights[lightIdx] };
+
+			// Project the corners of the box around the sphere
+			Vector2 minBoundingBox{ FLT_MAX, FLT_MAX };
+			Vector2 maxBoundingBox{ -FLT_MAX, -FLT_MAX };
+			int nrCornersBehindCamera{};
+			for (int cornerIdx{}; cornerIdx < 8; ++cornerIdx)
 			{
-				int pixelIdx = px + py * m_Width;
-				Vector2 curPixel(static_cast<float>(px),static_cast<float>(py));
-				if (m_ShowBoundingBox)
+				const Vector3 corner
 				{
-					m_pBackBufferPixels[pixelIdx] = SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255);
-					continue;
-				}
-	
-				const Vector2 v0ToPoint = curPixel - v0;
-				const Vector2 v1ToPoint = curPixel - v1;
-				const Vector2 v2ToPoint = curPixel - v2;
-	
-				float edge01PointCross = Vector2::Cross(edge01, v0ToPoint);
-				float edge12PointCross = Vector2::Cross(edge12, v1ToPoint);
-				float edge20PointCross = Vector2::Cross(edge20, v2ToPoint);
-	
-				bool isFrontFaceHit = edge01PointCross >= 0 && edge12PointCross >= 0 && edge20PointCross >= 0;
-				bool isBackFaceHit = edge01PointCross <= 0 && edge12PointCross <= 0 && edge20PointCross <= 0;
-	
-				if ((m_CullMode == CullMode::Back && !isFrontFaceHit) ||
-					(m_CullMode == CullMode::Front && !isBackFaceHit) ||
-					(m_CullMode == CullMode::None && !isBackFaceHit && !isFrontFaceHit)) continue;
-	
-				// Calculate the barycentric weights
-				float weightV0 = edge12PointCross / fullTriangleArea;
-				float weightV1 = edge20PointCross / fullTriangleArea;
-				float weightV2 = edge01PointCross / fullTriangleArea;
-	
-				// Calculate the Z depth at this pixel
-				float interpolatedZDepth = 1.0f / (weightV0 / verticesOut[vertexIdx0].position.z + weightV1 / verticesOut[vertexIdx1].position.z + weightV2 / verticesOut[vertexIdx2].position.z);
-	
-				// If the depth is outside the frustum, or if the current depth buffer is less than the current depth, continue to the next pixel
-				if (m_pDepthBufferPixels[pixelIdx] < interpolatedZDepth) continue;
-	
-				// Save the new depth
-				m_pDepthBufferPixels[pixelIdx] = interpolatedZDepth;
-	
-				// The pixel info
-				Vertex_Out pixelInfo;
-	
-				if (m_ShowDepthBuffer)
+					light.position.x + (cornerIdx & 1 ? light.radius : -light.radius),
+					light.position.y + (cornerIdx & 2 ? light.radius : -light.radius),
+					light.position.z + (cornerIdx & 4 ? light.radius : -light.radius)
+				};
+				const Vector4 clipCorner{ m_ViewProjectionMatrix.TransformPoint(Vector4{ corner, 1.0f }) };
+
+				// A corner behind the camera does not project onto the screen
+				if (clipCorner.w <= 0.0f)
 				{
-					// Remap the Z depth
-					float depthColor = Remap(interpolatedZDepth, 0.997f, 1.0f);
-	
-					// Set the color of the current pixel to showcase the depth
-					pixelInfo.color = { depthColor, depthColor, depthColor };
-	
+					++nrCornersBehindCamera;
+					continue;
 				}
-				else
+
+				const Vector2 rasterCorner{ CalculateNDCToRaster({ clipCorner.x / clipCorner.w, clipCorner.y / clipCorner.w, clipCorner.z / clipCorner.w }) };
+				minBoundingBox = Vector2::Min(minBoundingBox, rasterCorner);
+				maxBoundingBox = Vector2::Max(maxBoundingBox, rasterCorner);
+			}
+
+			// A light completely behind the camera lights nothing that is visible, one around the camera can light the whole screen
+			if (nrCornersBehindCamera == 8) continue;
+			if (nrCornersBehindCamera > 0)
+			{
+				minBoundingBox = { 0.0f, 0.0f };
+				maxBoundingBox = { static_cast<float>(m_Width), static_cast<float>(m_Height) };
+			}
+
+			const int startX{ std::max(static_cast<int>(minBoundingBox.x), 0) };
+			const int startY{ std::max(static_cast<int>(minBoundingBox.y), 0) };
+			const int endX{ std::min(static_cast<int>(maxBoundingBox.x) + 1, m_Width) };
+			const int endY{ std::min(static_cast<int>(maxBoundingBox.y) + 1, m_Height) };
+			if (startX >= endX || startY >= endY) continue;
+
+			for (int tileY{ startY / TileSize }; tileY <= (endY - 1) / TileSize; ++tileY)
+			{
+				for (int tileX{ startX / TileSize }; tileX <= (endX - 1) / TileSize; ++tileX)
 				{
-					// Calculate the W depth at this pixel
-					const float interpolatedWDepth
-					{
-						1.0f /
-							(weightV0 / verticesOut[vertexIdx0].position.w +
-							weightV1 / verticesOut[vertexIdx1].position.w +
-							weightV2 / verticesOut[vertexIdx2].position.w)
-					};
-	
-					// Calculate the UV coordinate at this pixel
-					pixelInfo.uv =
-					{
-						(weightV0 * verticesOut[vertexIdx0].uv / verticesOut[vertexIdx0].position.w +
-						weightV1 * verticesOut[vertexIdx1].uv / verticesOut[vertexIdx1].position.w +
-						weightV2 * verticesOut[vertexIdx2].uv / verticesOut[vertexIdx2].position.w)
-							* interpolatedWDepth
-					};
-	
-					// Calculate the normal at this pixel
-					pixelInfo.normal =
-						Vector3
-					{
-						(weightV0 * verticesOut[vertexIdx0].normal / verticesOut[vertexIdx0].position.w +
-						weightV1 * verticesOut[vertexIdx1].normal / verticesOut[vertexIdx1].position.w +
-						weightV2 * verticesOut[vertexIdx2].normal / verticesOut[vertexIdx2].position.w)
-							* interpolatedWDepth
-					}.Normalized();
-	
-					// Calculate the tangent at this pixel
-					pixelInfo.tangent =
-						Vector3
-					{
-						(weightV0 * verticesOut[vertexIdx0].tangent / verticesOut[vertexIdx0].position.w +
-						weightV1 * verticesOut[vertexIdx1].tangent / verticesOut[vertexIdx1].position.w +
-						weightV2 * verticesOut[vertexIdx2].tangent / verticesOut[vertexIdx2].position.w)
-							* interpolatedWDepth
-					}.Normalized();
-	
-					// Calculate the view direction at this pixel
-					pixelInfo.viewDirection =
-						Vector3
-					{
-						(weightV0 * verticesOut[vertexIdx0].viewDirection / verticesOut[vertexIdx0].position.w +
-						weightV1 * verticesOut[vertexIdx1].viewDirection / verticesOut[vertexIdx1].position.w +
-						weightV2 * verticesOut[vertexIdx2].viewDirection / verticesOut[vertexIdx2].position.w)
-							* interpolatedWDepth
-					}.Normalized();
-	
+					m_TileLights[tileX + tileY * m_NrTilesX].push_back(lightIdx);
 				}
-	
-				// Calculate the shading at this pixel and display it on screen
-				PixelShading(px + (py * m_Width), pixelInfo);
 			}
 		}
 	}
-#pragma region testing
 
-#pragma endregion
-
-	void SoftwareRenderer::ClearBackground(bool useUniformBackground) const
+	template<LightingMode Mode>
+	void SoftwareRenderer::LightPixels(const int (&pixelIdx)[PacketSize], int count, const std::vector<uint32_t>& tileLights) const
 	{
-		// Fill the background
-		int colorValue{ static_cast<int>((useUniformBackground ? 0.1f : 0.39f) * 255) };
-		SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, colorValue, colorValue, colorValue));
-	}
+		// The lanes after the last pixel repeat the first one, so every lane holds valid values
+		const GBufferTexel* pTexels[PacketSize]{};
+		Vector3 positions[PacketSize]{};
+		for (int laneIdx{}; laneIdx < PacketSize; ++laneIdx)
+		{
+			const int texelIdx{ pixelIdx[laneIdx < count ? laneIdx : 0] };
+			pTexels[laneIdx] = &m_pGBuffer[texelIdx];
+
+			// Reconstruct the world position of the pixel from its view depth
+			const float depth{ pTexels[laneIdx]->depth };
+			const float ndcX{ (texelIdx % m_Width) * 2.0f / m_Width - 1.0f };
+			const float ndcY{ 1.0f - (texelIdx / m_Width) * 2.0f / m_Height };
+			positions[laneIdx] = m_InverseViewMatrix.TransformPoint(ndcX * depth * m_InverseProjectionScale.x, ndcY * depth * m_InverseProjectionScale.y, depth);
+		}
 
-	void SoftwareRenderer::ResetDepthBuffer() const
-	{
-		// The nr of pixels in the buffer
-		const int nrPixels{ m_Width * m_Height };
+		const Vector3Packet position{ Vector3Packet::FromLanes(positions[0], positions[1], positions[2], positions[3]) };
+		const Vector3Packet viewDirection{ (position - Vector3Packet::Splat(m_InverseViewMatrix.GetTranslation())).Normalized() };
 
-		// Set everything in the depth buffer to the value FLT_MAX
-		std::fill_n(m_pDepthBufferPixels, nrPixels, FLT_MAX);
-	}
+		SurfacePacket surface{};
+		surface.normal = Vector3Packet::FromLanes(pTexels[0]->normal, pTexels[1]->normal, pTexels[2]->normal, pTexels[3]->normal);
+		surface.diffuse = UnpackColors(_mm_setr_epi32(pTexels[0]->diffuse, pTexels[1]->diffuse, pTexels[2]->diffuse, pTexels[3]->diffuse));
+		surface.specular = UnpackColors(_mm_setr_epi32(pTexels[0]->specular, pTexels[1]->specular, pTexels[2]->specular, pTexels[3]->specular));
+		surface.exponent = _mm_setr_ps(pTexels[0]->exponent, pTexels[1]->exponent, pTexels[2]->exponent, pTexels[3]->exponent);
 
-	void SoftwareRenderer::PixelShading(int pixelIdx, const Vertex_Out& pixelInfo) const
-	{
-		// The normal that should be used in calculations
-		Vector3 useNormal{ pixelInfo.normal };
+		// Evaluates the specular power the way that was chosen for this frame
+		const PixelShaderInput powInput{ {}, nullptr, &m_PowLookupTable, m_SpecularPowMode };
+		auto specularPow = [&powInput](__m128 base, __m128 exponent) { return powInput.SpecularPow(base, exponent); };
 
-		// If the normal map is active
-		if (m_NormalMapActive)
-		{
-			// Calculate the binormal in this pixel
-			Vector3 binormal = Vector3::Cross(pixelInfo.normal, pixelInfo.tangent);
+		// The directional light lights every pixel
+		ColorRGBPacket finalColor{ SoftwarePhongShader::ShadeLight<Mode>(surface, Vector3Packet::Splat(-SoftwarePhongShader::GetLightDirection()), viewDirection, _mm_set1_ps(SoftwarePhongShader::LightIntensity), ColorRGBPacket::Splat({ 1.0f, 1.0f, 1.0f }), specularPow) };
 
-			// Create a matrix using the tangent, normal and binormal
-			Matrix tangentSpaceAxis = Matrix{ pixelInfo.tangent, binormal, pixelInfo.normal, Vector3::Zero };
+		for (uint32_t lightIdx : tileLights)
+		{
+			const SoftwarePointLight& light{ m_PointLights[lightIdx] };
+			const Vector3Packet toLight{ Vector3Packet::Splat(light.position) - position };
 
-			// Sample a color from the normal map and clamp it between -1 and 1
-			ColorRGB currentNormalMap{ 2.0f * m_pNormalTexture->Sample(pixelInfo.uv) - ColorRGB{ 1.0f, 1.0f, 1.0f } };
+			// The light fades out smoothly to nothing at its radius
+			const __m128 distanceSquared{ Vector3Packet::Dot(toLight, toLight) };
+			const __m128 falloff{ _mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(distanceSquared, _mm_set1_ps(1.0f / (light.radius * light.radius)))), _mm_setzero_ps()) };
+			const __m128 attenuation{ _mm_mul_ps(falloff, falloff) };
 
-			// Make a vector3 of the colorRGB object
-			Vector3 normalMapSample{ currentNormalMap.r, currentNormalMap.g, currentNormalMap.b };
+			// Most lights of a tile do not reach all of its pixels
+			if (_mm_movemask_ps(_mm_cmpgt_ps(attenuation, _mm_setzero_ps())) == 0) continue;
 
-			// Transform the normal map value using the calculated matrix of this pixel
-			useNormal = tangentSpaceAxis.TransformVector(normalMapSample);
+			finalColor += SoftwarePhongShader::ShadeLight<Mode>(surface, toLight.Normalized(), viewDirection, _mm_set1_ps(light.intensity), ColorRGBPacket::Splat(light.color) * attenuation, specularPow);
 		}
-		else
+
+		finalColor += SoftwarePhongShader::GetAmbientColor<Mode>();
+		finalColor.MaxToOne();
+
+		alignas(16) float red[PacketSize];
+		alignas(16) float green[PacketSize];
+		alignas(16) float blue[PacketSize];
+		_mm_store_ps(red, finalColor.r);
+		_mm_store_ps(green, finalColor.g);
+		_mm_store_ps(blue, finalColor.b);
+
+		for (int laneIdx{}; laneIdx < count; ++laneIdx)
 		{
-			// If the normal map is not active, use the original normal
-			useNormal = pixelInfo.normal;
+			m_pBackBufferPixels[pixelIdx[laneIdx]] = SDL_MapRGB(m_pBackBuffer->format,
+				static_cast<uint8_t>(red[laneIdx] * 255),
+				static_cast<uint8_t>(green[laneIdx] * 255),
+				static_cast<uint8_t>(blue[laneIdx] * 255));
 		}
+	}
 
-		// Create the light data
-		Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
-		lightDirection.Normalize();
-		const float lightIntensity{ 7.0f };
-		const float specularShininess{ 25.0f };
+	template<LightingMode Mode>
+	void SoftwareRenderer::LightTile(int tileIdx, const ScreenRect& tileRect) const
+	{
+		const std::vector<uint32_t>& tileLights{ m_TileLights[tileIdx] };
 
-		// The final color that will be rendered
-		ColorRGB finalColor{};
-		ColorRGB ambientColor{ 0.025f, 0.025f, 0.025f };
+		// The lit pixels are collected and lit per packet
+		int pixelIdx[PacketSize]{};
+		int count{};
 
-		// Depending on the rendering state, do other things
-		if (m_ShowDepthBuffer)
+		for (int py{ tileRect.minY }; py < tileRect.maxY; ++py)
 		{
+			for (int px{ tileRect.minX }; px < tileRect.maxX; ++px)
+			{
+				const int texelIdx{ px + py * m_Width };
+				const GBufferTexel& texel{ m_pGBuffer[texelIdx] };
 
-			// Only render the depth which is saved in the color attribute of the pixel info
-			finalColor += pixelInfo.color;
-		}
-		else
-		{
-			// Calculate the observed area in this pixel
-			const float observedArea{ Vector3::DotClamped(useNormal.Normalized(), -lightDirection.Normalized()) };
+				if (texel.surfaceType == SurfaceType::None) continue;
 
-			// Depending on the lighting mode, different shading should be applied
-			switch (m_LightingMode)
-			{
-				case LightingMode::Combined:
+				// The color of unlit surfaces is copied as it is
+				if (texel.surfaceType == SurfaceType::Unlit)
 				{
-					// Calculate the lambert shader
-					const ColorRGB lambert{ LightingUtils::Lambert(1.0f, m_pDiffuseTexture->Sample(pixelInfo.uv)) };
-					// Calculate the phong exponent
-					const float specularExp{ specularShininess * m_pGlossinessTexture->Sample(pixelInfo.uv).r };
-					// Calculate the phong shader
-					const ColorRGB specular{ m_pSpecularTexture->Sample(pixelInfo.uv) * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixelInfo.viewDirection, useNormal) };
-
-					// Lambert + Phong + ObservedArea
-					finalColor += (lightIntensity * lambert + specular) * observedArea + ambientColor;
-					break;
-				}
-				case LightingMode::ObservedArea:
-				{
-					// Only show the calculated observed area
-					finalColor += ColorRGB{ observedArea, observedArea, observedArea };
-					break;
-				}
-				case LightingMode::Diffuse:
-				{
-					// Calculate the lambert shader and display it on screen together with the observed area
-					finalColor += lightIntensity * observedArea * LightingUtils::Lambert(1.0f, m_pDiffuseTexture->Sample(pixelInfo.uv));
-					break;
+					m_pBackBufferPixels[texelIdx] = SDL_MapRGB(m_pBackBuffer->format, texel.diffuse & 0xFF, (texel.diffuse >> 8) & 0xFF, (texel.diffuse >> 16) & 0xFF);
+					continue;
 				}
-				case LightingMode::Specular:
+
+				pixelIdx[count] = texelIdx;
+				if (++count == PacketSize)
 				{
-					// Calculate the phong exponent
-					const float specularExp{ specularShininess * m_pGlossinessTexture->Sample(pixelInfo.uv).r };
-					// Calculate the phong shader
-					const ColorRGB specular{ m_pSpecularTexture->Sample(pixelInfo.uv) * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixelInfo.viewDirection, useNormal) };
-					// Phong + observed area
-					finalColor += specular * observedArea;
-					break;
+					LightPixels<Mode>(pixelIdx, count, tileLights);
+					count = 0;
 				}
 			}
-
-			// Create the ambient color	and add it to the final color
-			const ColorRGB ambientColor{ 0.025f, 0.025f, 0.025f };
-			finalColor += ambientColor;
 		}
 
-		//Update Color in Buffer
-		finalColor.MaxToOne();
+		// Light the pixels that are left
+		if (count > 0) LightPixels<Mode>(pixelIdx, count, tileLights);
+	}
 
-		m_pBackBufferPixels[pixelIdx] = SDL_MapRGB(m_pBackBuffer->format,
-			static_cast<uint8_t>(finalColor.r * 255),
-			static_cast<uint8_t>(finalColor.g * 255),
-			static_cast<uint8_t>(finalColor.b * 255));
+	void SoftwareRenderer::LightTile(int tileIdx, const ScreenRect& tileRect) const
+	{
+		// The lighting mode is chosen once per tile instead of for every pixel
+		switch (m_LightingMode)
+		{
+		case LightingMode::Combined:
+			LightTile<LightingMode::Combined>(tileIdx, tileRect);
+			break;
+		case LightingMode::ObservedArea:
+			LightTile<LightingMode::ObservedArea>(tileIdx, tileRect);
+			break;
+		case LightingMode::Diffuse:
+			LightTile<LightingMode::Diffuse>(tileIdx, tileRect);
+			break;
+		case LightingMode::Specular:
+			LightTile<LightingMode::Specular>(tileIdx, tileRect);
+			break;
+		}
 	}
 
 	inline Vector2 dae::SoftwareRenderer::CalculateNDCToRaster(const Vector3& ndcVertex) const
@@ -537,6 +1504,8 @@ namespace dae
 
 	void SoftwareRenderer::ToggleDepthBuffer()
 	{
+		m_IsFullRedrawNeeded = true;
+
 		m_ShowDepthBuffer = !m_ShowDepthBuffer;
 
 		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
@@ -553,6 +1522,8 @@ namespace dae
 
 	void SoftwareRenderer::ToggleBoundingBoxVisible()
 	{
+		m_IsFullRedrawNeeded = true;
+
 		m_ShowBoundingBox = !m_ShowBoundingBox;
 
 		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
@@ -569,6 +1540,8 @@ namespace dae
 
 	void dae::SoftwareRenderer::ToggleLightingMode()
 	{
+		m_IsFullRedrawNeeded = true;
+
 		// Shuffle through all the lighting modes
 		m_LightingMode = static_cast<LightingMode>((static_cast<int>(m_LightingMode) + 1) % (static_cast<int>(LightingMode::Specular) + 1));
 
@@ -576,16 +1549,16 @@ namespace dae
 		std::cout << "**(SOFTWARE) Shading Mode = ";
 		switch (m_LightingMode)
 		{
-		case dae::SoftwareRenderer::LightingMode::Combined:
+		case LightingMode::Combined:
 			std::cout << "COMBINED\n";
 			break;
-		case dae::SoftwareRenderer::LightingMode::ObservedArea:
+		case LightingMode::ObservedArea:
 			std::cout << "OBSERVED_AREA\n";
 			break;
-		case dae::SoftwareRenderer::LightingMode::Diffuse:
+		case LightingMode::Diffuse:
 			std::cout << "DIFFUSE\n";
 			break;
-		case dae::SoftwareRenderer::LightingMode::Specular:
+		case LightingMode::Specular:
 			std::cout << "SPECULAR\n";
 			break;
 		}
@@ -593,6 +1566,8 @@ namespace dae
 
 	void dae::SoftwareRenderer::ToggleNormalMap()
 	{
+		m_IsFullRedrawNeeded = true;
+
 		// Toggle the normal map active variable
 		m_NormalMapActive = !m_NormalMapActive;
 
@@ -633,6 +1608,101 @@ namespace dae
 
 	}
 
+	void SoftwareRenderer::ToggleSpecularPow()
+	{
+		m_IsFullRedrawNeeded = true;
+
+		// Shuffle through the ways to evaluate the specular power
+		m_SpecularPowMode = static_cast<SpecularPowMode>((static_cast<int>(m_SpecularPowMode) + 1) % (static_cast<int>(SpecularPowMode::LookupTable) + 1));
+
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) Specular Pow = ";
+		switch (m_SpecularPowMode)
+		{
+		case SpecularPowMode::Exact:
+			std::cout << "POWF\n";
+			break;
+		case SpecularPowMode::Polynomial:
+			std::cout << "FAST_POW\n";
+			break;
+		case SpecularPowMode::LookupTable:
+			std::cout << "LOOKUP_TABLE\n";
+			break;
+		}
+	}
+
+	void SoftwareRenderer::BenchmarkSpecularPow() const
+	{
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) ";
+		m_PowLookupTable.Benchmark();
+	}
+
+	void SoftwareRenderer::ToggleShadingRate()
+	{
+		m_IsFullRedrawNeeded = true;
+
+		// Shuffle through the shading rates, the adaptive rate starts from full rate shading in every tile
+		m_ShadingRate = static_cast<ShadingRate>((static_cast<int>(m_ShadingRate) + 1) % (static_cast<int>(ShadingRate::Adaptive) + 1));
+		std::fill_n(m_pTileShadingBlockSizes, m_IsTileDirty.size(), static_cast<uint8_t>(1));
+
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) Shading Rate = ";
+		switch (m_ShadingRate)
+		{
+		case ShadingRate::Rate1x1:
+			std::cout << "1X1\n";
+			break;
+		case ShadingRate::Rate2x2:
+			std::cout << "2X2\n";
+			break;
+		case ShadingRate::Rate4x4:
+			std::cout << "4X4\n";
+			break;
+		case ShadingRate::Adaptive:
+			std::cout << "ADAPTIVE\n";
+			break;
+		}
+	}
+
+	void SoftwareRenderer::ToggleDeferredLighting()
+	{
+		m_IsFullRedrawNeeded = true;
+
+		m_IsDeferredLighting = !m_IsDeferredLighting;
+
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) Deferred Lighting (" << m_PointLights.size() << " point lights) ";
+		if (m_IsDeferredLighting)
+		{
+			std::cout << "ON\n";
+		}
+		else
+		{
+			std::cout << "OFF\n";
+		}
+	}
+
+	void SoftwareRenderer::ToggleTransparencyMode()
+	{
+		m_IsFullRedrawNeeded = true;
+		m_IsBinningNeeded = true;
+
+		m_TransparencyMode = m_TransparencyMode == TransparencyMode::Sorted ? TransparencyMode::WeightedBlended : TransparencyMode::Sorted;
+
+		SetConsoleTextAttribute(m_hConsole, 13); // 13 is the color code for purple
+		std::cout << "**(SOFTWARE) Transparency = ";
+		switch (m_TransparencyMode)
+		{
+		case TransparencyMode::Sorted:
+			std::cout << "SORTED\n";
+			break;
+		case TransparencyMode::WeightedBlended:
+			std::cout << "WEIGHTED_BLENDED\n";
+			break;
+		}
+	}
+
 	bool dae::SoftwareRenderer::SaveBufferToImage() const
 	{
 		return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <utility>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "DataTypes.h"
+#include "MathPacket.h"
+#include "PowLookupTable.h"
+#include "SoftwareShader.h"
 
 namespace dae
 {
 	class Mesh;
 	class Camera;
-	class Texture;
 
 	class SoftwareRenderer
 	{
@@ -23,27 +28,115 @@ namespace dae
 		SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
 		SoftwareRenderer& operator=(SoftwareRenderer&&) noexcept = delete;
 
-		void Render(const std::unique_ptr<Camera>& pCamera, bool useUniformBackground);
+		void Render(const std::vector<Mesh*>& pMeshes, const std::unique_ptr<Camera>& pCamera, bool useUniformBackground);
+		void PresentPreviousFrame() const;
 		void ToggleDepthBuffer();
 		void ToggleBoundingBoxVisible();
 		void ToggleLightingMode();
 		void ToggleNormalMap();
 		void ToggleMultiThreading();
-		void SetTextures(Texture* pDiffuseTexture, Texture* pNormalTexture, Texture* pSpecularTexture, Texture* pGlossinessTexture);
-		void SetMesh(Mesh* pMesh);
+		void ToggleSpecularPow();
+		void BenchmarkSpecularPow() const;
+		void ToggleTransparencyMode();
+		void ToggleShadingRate();
+		void ToggleDeferredLighting();
+		void SetMaterial(const Mesh* pMesh, const SoftwareMaterial& material);
 		void SetCulling(CullMode cullMode);
+		void SetPointLights(const std::vector<SoftwarePointLight>& pointLights);
 
 		bool SaveBufferToImage() const;
 
 	private:
-		enum class LightingMode
+		// How transparent triangles are combined with what is behind them
+		enum class TransparencyMode
 		{
-			Combined,
-			ObservedArea,
-			Diffuse,
-			Specular
+			// Blended back to front, the triangles of every tile are sorted on depth
+			Sorted,
+			// Weighted blended order independent transparency, the triangles are accumulated in any order and composited once per tile
+			WeightedBlended
 		};
 
+		// How many pixels share the shading of one pixel, depth and coverage are always tested per pixel
+		enum class ShadingRate
+		{
+			Rate1x1,
+			Rate2x2,
+			Rate4x4,
+			// Every tile picks one of the rates above from the contrast of its previous result
+			Adaptive
+		};
+
+		// How a kernel writes its pixels
+		enum class BlendMode
+		{
+			Opaque,
+			AlphaBlended,
+			WeightedBlended,
+			// Opaque, but the surface is written to the G-buffer and colored by the lighting pass
+			GBuffer
+		};
+
+		// The glossiness map is scaled by this to get the specular exponent
+		static constexpr float SpecularShininess{ 25.0f };
+
+		// The modes the raster and shade kernel is specialized for, every permutation is instantiated for every shader so the pixel loop has no mode branches
+		struct RenderModes
+		{
+			CullMode cullMode{};
+			bool showBoundingBox{};
+			bool showDepthBuffer{};
+			ShadingModes shading{};
+			// Not part of the permutation index, transparent and deferred kernels are created separately by AsTransparent and AsDeferred
+			BlendMode blendMode{};
+		};
+		static constexpr uint32_t NrCullModes{ static_cast<uint32_t>(CullMode::None) + 1 };
+		static constexpr uint32_t NrLightingModes{ static_cast<uint32_t>(LightingMode::Specular) + 1 };
+		static constexpr uint32_t NrRenderModePermutations{ NrCullModes * 2 * 2 * 2 * NrLightingModes };
+
+		static constexpr RenderModes DecodeRenderModes(uint32_t permutationIdx)
+		{
+			return RenderModes
+			{
+				static_cast<CullMode>(permutationIdx % NrCullModes),
+				permutationIdx / NrCullModes % 2 == 1,
+				permutationIdx / (NrCullModes * 2) % 2 == 1,
+				ShadingModes
+				{
+					permutationIdx / (NrCullModes * 4) % 2 == 1,
+					static_cast<LightingMode>(permutationIdx / (NrCullModes * 8))
+				}
+			};
+		}
+		// The normal map is turned off for materials that have none
+		uint32_t EncodeRenderModes(const SoftwareMaterial& material) const;
+
+		// Transparent triangles are blended over the opaque ones without culling, the debug views do not show them
+		static constexpr RenderModes AsTransparent(RenderModes modes, BlendMode blendMode)
+		{
+			return RenderModes{ CullMode::None, false, false, modes.shading, blendMode };
+		}
+
+		// Opaque triangles write the G-buffer in the deferred mode, the debug views never use it
+		static constexpr RenderModes AsDeferred(RenderModes modes)
+		{
+			return RenderModes{ modes.cullMode, false, false, modes.shading, BlendMode::GBuffer };
+		}
+
+		// The attributes the shader reads in these modes, only these are interpolated for every pixel
+		template<SoftwareShader Shader>
+		static constexpr Varyings GetRequiredVaryings(RenderModes modes)
+		{
+			// The depth and bounding box views only need the depth
+			if (modes.showDepthBuffer || modes.showBoundingBox) return Varyings{};
+
+			if constexpr (DeferredSoftwareShader<Shader>)
+			{
+				if (modes.blendMode == BlendMode::GBuffer) return Shader::GetSurfaceVaryings(modes.shading);
+			}
+
+			return Shader::GetVaryings(modes.shading);
+		}
+
 		//console color code thing
 		HANDLE m_hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 
@@ -59,6 +152,11 @@ namespace dae
 
 		float* m_pDepthBufferPixels{};
 
+		// The sum of the weighted premultiplied colors and alphas (4 floats per pixel) and the product of the inverse alphas of the transparent pixels
+		// Every tile only uses its own pixels, so the tiles can accumulate in parallel
+		float* m_pAccumulationPixels{};
+		float* m_pRevealagePixels{};
+
 		ThreadMode m_ThreadMode = ThreadMode::Synchronous;
 
 		ThreadMode m_NextMode = ThreadMode::Synchronous;
@@ -73,22 +171,236 @@ namespace dae
 		CullMode m_CullMode{ CullMode::Back };
 		bool m_RotateMesh{ true };
 		bool m_NormalMapActive{ true };
+		SpecularPowMode m_SpecularPowMode{ SpecularPowMode::Polynomial };
+		TransparencyMode m_TransparencyMode{ TransparencyMode::Sorted };
+		PowLookupTable m_PowLookupTable{ SpecularShininess };
 
 
 		//resources
-		Mesh* m_pMesh{};
-		Texture* m_pDiffuseTexture{};
-		Texture* m_pNormalTexture{};
-		Texture* m_pSpecularTexture{};
-		Texture* m_pGlossinessTexture{};
+		// Only meshes with a material are rendered by the software rasterizer
+		std::unordered_map<const Mesh*, SoftwareMaterial> m_Materials{};
+		// The object space vertices of the quantized meshes, decoded once and shared by all their instances
+		std::unordered_map<const Mesh*, std::vector<Vertex>> m_DecodedVertices{};
+
+		// A rectangle of pixels, the maximum is exclusive
+		struct ScreenRect
+		{
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+		};
+
+		// The screen is split into tiles, a tile keeps its color and depth of the previous frame unless the mesh covered it then or covers it now
+		// Every tile also has a bin with the triangles that overlap it, so the tiles can be rasterized in parallel
+		static constexpr int TileSize{ 32 };
+		int m_NrTilesX{};
+		int m_NrTilesY{};
+		std::vector<uint8_t> m_IsTileDirty{};
+		std::vector<int> m_DirtyTiles{};
+		std::vector<std::vector<uint32_t>> m_TileBins{};
+		// The transparent triangles that overlap every tile, sorted back to front
+		std::vector<std::vector<uint32_t>> m_TransparentTileBins{};
+
+		// The width of the pixel blocks that are shaded once, for every tile, only used by ShadingRate::Adaptive
+		// Blocks are aligned to the tiles, so the tile size has to be a multiple of every block width
+		static constexpr int MaxShadingBlockSize{ 4 };
+		static_assert(TileSize % MaxShadingBlockSize == 0);
+		uint8_t* m_pTileShadingBlockSizes{};
+		ShadingRate m_ShadingRate{ ShadingRate::Rate1x1 };
+
+		// What the deferred mode knows about the visible surface of a pixel, the lighting pass turns it into a color
+		enum class SurfaceType : uint8_t
+		{
+			None,
+			Lit,
+			// Colored by a shader without a surface, the diffuse color is the final color
+			Unlit
+		};
+		struct GBufferTexel
+		{
+			Vector3 normal{};
+			// The view depth, the lighting pass reconstructs the position from it
+			float depth{};
+			// 8 bits per channel, the textures they come from have no more
+			uint32_t diffuse{};
+			uint32_t specular{};
+			float exponent{};
+			SurfaceType surfaceType{};
+		};
+		GBufferTexel* m_pGBuffer{};
+		bool m_IsDeferredLighting{};
 
-		//Function that transforms the vertices from the mesh from World space to Screen space
-		void VertexTransformationFunction(std::vector<Vertex_Out>& verticesOut, const std::unique_ptr<Camera>& pCamera);
-		void RenderTriangle(const std::vector<Vector2>& rasterVertices, const std::vector<Vertex_Out>& verticesOut, const std::vector<uint32_t>& indices, int vertexIdx, bool swapVertices) const;
+		// The point lights of the deferred mode, and the ones whose sphere overlaps every tile
+		std::vector<SoftwarePointLight> m_PointLights{};
+		std::vector<std::vector<uint32_t>> m_TileLights{};
+
+		// The view of the frame, the lighting pass reconstructs the positions of the pixels with it
+		Matrix m_ViewProjectionMatrix{};
+		Matrix m_InverseViewMatrix{};
+		Vector2 m_InverseProjectionScale{};
+
+		// Changes of the view or the settings make every tile dirty
+		bool m_IsFullRedrawNeeded{ true };
+		// The transparent triangles are only sorted for TransparencyMode::Sorted, changing the mode bins them again
+		bool m_IsBinningNeeded{};
+		uint32_t m_PreviousCameraVersion{};
+		bool m_PreviousUseUniformBackground{};
+
+		// Everything the culling and vertex stage of one draw item depend on, their results are reused as long as it does not change
+		struct TransformState
+		{
+			const Mesh* pMesh{};
+			uint32_t worldMatrixVersion{};
+			uint32_t cameraVersion{};
+			const MeshLod* pLod{};
+			CullMode cullMode{};
+			uint32_t instanceIdx{};
+			// Only changes for streamed meshes, when clusters were loaded or evicted
+			uint32_t residencyVersion{};
+
+			bool operator==(const TransformState& other) const = default;
+		};
+
+		// A triangle that passed setup, its indices point into the vertices of the frame
+		struct RasterTriangle
+		{
+			uint32_t vertexIdx0{};
+			uint32_t vertexIdx1{};
+			uint32_t vertexIdx2{};
+			uint32_t drawItemIdx{};
+		};
+		std::vector<RasterTriangle> m_Triangles{};
+
+		// The kernels specialized for a shader, every draw item picks the ones of its shader instead of dispatching per vertex or pixel
+		using TransformDrawItemFunction = void (SoftwareRenderer::*)(uint32_t, const Matrix&, const Vector3&);
+		using RenderTriangleFunction = void (SoftwareRenderer::*)(const RasterTriangle&, const ScreenRect&, int) const;
+		struct ShaderKernels
+		{
+			TransformDrawItemFunction pTransformDrawItem{};
+			std::array<RenderTriangleFunction, NrRenderModePermutations> pRenderTriangles{};
+			// Indexed by the same permutation, but only the shading modes select a different kernel
+			std::array<RenderTriangleFunction, NrRenderModePermutations> pRenderAlphaBlendedTriangles{};
+			std::array<RenderTriangleFunction, NrRenderModePermutations> pRenderWeightedBlendedTriangles{};
+			std::array<RenderTriangleFunction, NrRenderModePermutations> pRenderDeferredTriangles{};
+		};
+		template<SoftwareShader Shader, size_t... PermutationIdx>
+		static constexpr ShaderKernels CreateShaderKernels(std::index_sequence<PermutationIdx...>);
+		static const ShaderKernels& GetShaderKernels(uint32_t shaderIdx);
+
+		// One visible instance of a mesh in the frame
+		struct DrawItem
+		{
+			Mesh* pMesh{};
+			const SoftwareMaterial* pMaterial{};
+			TransformState transformState{};
+			// The screen area its triangles cover
+			ScreenRect footprint{};
+			// Transparent draw items are rendered after all opaque ones and blended over them
+			bool isTransparent{};
+			// The raster and shade kernel for the modes of the frame, picked before the tiles are rendered
+			RenderTriangleFunction pRenderTriangle{};
+		};
+		std::vector<DrawItem> m_DrawItems{};
+		std::vector<DrawItem> m_PreviousDrawItems{};
+
+		// Finds the draw item of an instance in the previous frame, by its mesh and instance index
+		using DrawItemKey = std::pair<const Mesh*, uint32_t>;
+		struct DrawItemKeyHash
+		{
+			size_t operator()(const DrawItemKey& key) const
+			{
+				return std::hash<const Mesh*>{}(key.first) ^ (std::hash<uint32_t>{}(key.second) * 0x9E3779B9u);
+			}
+		};
+		std::unordered_map<DrawItemKey, size_t, DrawItemKeyHash> m_PreviousDrawItemIndices{};
+
+		// The pixels of a triangle that passed the depth test, they are shaded together once the packet is full
+		// With coarse shading a lane is a block of pixels, its index is the top left pixel and the mask holds the covered pixels of the block
+		struct PixelPacket
+		{
+			int pixelIdx[PacketSize]{};
+			Vertex_Out pixelInfo[PacketSize]{};
+			uint16_t coverageMask[PacketSize]{};
+			int count{};
+			int shadingBlockSize{ 1 };
+		};
+
+		// The post-transform vertices of all draw items, from the last time the vertex stage ran
+		std::vector<Vertex_Out> m_VerticesOut{};
+		std::vector<Vector2> m_VerticesRasterSpace{};
+
+		// The triangles and vertices of the meshlets that survived culling, with the index width of the mesh
+		std::vector<uint32_t> m_VisibleIndices{};
+		std::vector<uint16_t> m_VisibleIndices16{};
+		std::vector<uint8_t> m_IsVertexUsed{};
+		// The index of every used mesh vertex in the vertices of the frame
+		std::vector<uint32_t> m_VertexRemap{};
+
+		// The squared distance to the camera and the index of every meshlet that survived culling, used to render them front to back
+		std::vector<std::pair<float, uint32_t>> m_VisibleMeshlets{};
+
+		//Functions that build the draw items of the frame and find the tiles that changed since the previous frame
+		void CollectDrawItems(const std::vector<Mesh*>& pMeshes, Camera& camera);
+		void MarkChangedDrawItems();
+		void MarkDirtyTiles(const ScreenRect& rect);
+
+		//Functions that cull and transform all draw items into the vertices of the frame and set up their triangles, templated on the shader and the width of the indices
+		void TransformDrawItems(Camera& camera);
+		template<SoftwareShader Shader>
+		void TransformDrawItem(uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition);
+		template<SoftwareShader Shader, typename IndexType>
+		void TransformMeshDrawItem(const std::vector<IndexType>& meshIndices, std::vector<IndexType>& visibleIndices, uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition);
+		template<typename IndexType>
+		void SetupTriangles(const std::vector<IndexType>& indices, uint32_t drawItemIdx);
+		void ConvertVerticesToRasterSpace(size_t firstVertexIdx);
+		ScreenRect CalculateFootprint(size_t firstVertexIdx, size_t endVertexIdx) const;
+
+		//Function that culls the resident clusters of a streamed mesh, transforms their vertices and sets up their triangles
+		template<SoftwareShader Shader>
+		void TransformStreamedDrawItem(uint32_t drawItemIdx, const Matrix& viewProjectionMatrix, const Vector3& cameraPosition);
+
+		//Function that culls the meshlets of the mesh and collects the triangles and vertices that have to be rendered
+		template<typename IndexType>
+		void CullMeshlets(const Mesh* pMesh, const std::vector<IndexType>& indices, std::vector<IndexType>& visibleIndices, const Matrix& worldViewProjectionMatrix, const Vector3& objectSpaceCameraPosition, CullMode cullMode);
+		//Function that collects the visible meshlets front to back, getMeshlet returns nullptr for meshlets that cannot be rendered
+		template<typename MeshletFunction>
+		void CollectVisibleMeshlets(uint32_t firstMeshletIdx, uint32_t endMeshletIdx, MeshletFunction getMeshlet, const Matrix& worldViewProjectionMatrix, const Vector3& objectSpaceCameraPosition, CullMode cullMode);
+		bool IsMeshletFacingAway(const Meshlet& meshlet, const Vector3& objectSpaceCameraPosition, CullMode cullMode) const;
+
+		//Function that transforms the used vertices from the mesh from World space to Screen space and adds them to the vertices of the frame
+		template<SoftwareShader Shader>
+		void VertexTransformationFunction(Mesh* pMesh, const VertexShaderConstants& constants);
+		template<SoftwareShader Shader>
+		Vertex_Out TransformVertex(const Vertex& vertex, const VertexShaderConstants& constants) const;
+
+		//Functions that sort the triangles into the tiles they overlap and rasterize the dirty tiles
+		void BinTriangles();
+		void RenderTiles(bool useUniformBackground);
+		void RenderTile(int tileIdx, uint32_t clearColor) const;
+		void RenderTileLayers(int tileIdx, const ScreenRect& tileRect, uint32_t clearColor, int shadingBlockSize) const;
+		int EstimateShadingBlockSize(const ScreenRect& tileRect) const;
+		bool IsLightingDeferred() const;
+		template<RenderModes Modes, SoftwareShader Shader>
+		void RenderTriangle(const RasterTriangle& triangle, const ScreenRect& tileRect, int shadingBlockSize) const;
 
-		void ClearBackground(bool useUniformBackground) const;
 		void ResetDepthBuffer() const;
-		void PixelShading(int pixelIdx, const Vertex_Out& pixelInfo) const;
+		template<RenderModes Modes, SoftwareShader Shader>
+		void PixelShading(const PixelPacket& packet, const SoftwareMaterial& material) const;
+		template<typename PixelFunction>
+		void ForEachCoveredPixel(const PixelPacket& packet, int laneIdx, PixelFunction pixelFunction) const;
+		ColorRGBPacket ReadBackBuffer(const PixelPacket& packet) const;
+		static __m128i PackColors(const ColorRGBPacket& colors);
+		static ColorRGBPacket UnpackColors(__m128i packedColors);
+
+		//Functions that light the G-buffer of the deferred mode, with the point lights whose sphere overlaps the tile
+		void BinPointLights();
+		void LightTile(int tileIdx, const ScreenRect& tileRect) const;
+		template<LightingMode Mode>
+		void LightTile(int tileIdx, const ScreenRect& tileRect) const;
+		template<LightingMode Mode>
+		void LightPixels(const int (&pixelIdx)[PacketSize], int count, const std::vector<uint32_t>& tileLights) const;
+		void CompositeWeightedBlended(const ScreenRect& tileRect) const;
 		inline Vector2 CalculateNDCToRaster(const Vector3& ndcVertex) const;
 		inline bool IsOutsideFrustum(const Vector4& v) const;
 
@@ -0,0 +1,158 @@
+#pragma once
+#include <concepts>
+#include "DataTypes.h"
+#include "MathPacket.h"
+#include "PowLookupTable.h"
+#include "Texture.h"
+
+namespace dae
+{
+	// The textures the software rasterizer shades a mesh with, the normal map is optional
+	struct SoftwareMaterial
+	{
+		Texture* pDiffuseTexture{};
+		Texture* pNormalTexture{};
+		Texture* pSpecularTexture{};
+		Texture* pGlossinessTexture{};
+		// The shader the mesh is rendered with, an index in SoftwareShaders (see GetSoftwareShaderIdx)
+		uint32_t shaderIdx{};
+	};
+
+	enum class LightingMode
+	{
+		Combined,
+		ObservedArea,
+		Diffuse,
+		Specular
+	};
+
+	// How the specular power is evaluated, it is chosen at runtime so it does not multiply the kernel permutations
+	enum class SpecularPowMode
+	{
+		Exact,
+		Polynomial,
+		LookupTable
+	};
+
+	// The settings of the software renderer a pixel shader is specialized for
+	// The normal map is only turned on for materials that have one
+	struct ShadingModes
+	{
+		bool useNormalMap{};
+		LightingMode lightingMode{};
+	};
+
+	// The attributes a pixel shader reads, only these are interpolated for every pixel
+	struct Varyings
+	{
+		bool uv{};
+		bool normal{};
+		bool tangent{};
+		bool viewDirection{};
+	};
+
+	// Everything the vertex shader knows about the instance it transforms
+	struct VertexShaderConstants
+	{
+		Matrix worldMatrix{};
+		Matrix worldViewProjectionMatrix{};
+		Vector3 cameraPosition{};
+	};
+
+	// A point light of the deferred mode, its light fades out to nothing at its radius
+	struct SoftwarePointLight
+	{
+		Vector3 position{};
+		ColorRGB color{};
+		float intensity{};
+		float radius{};
+	};
+
+	// What a deferred shader knows about the surface in every lane before it is lit
+	struct SurfacePacket
+	{
+		Vector3Packet normal{};
+		ColorRGBPacket diffuse{};
+		ColorRGBPacket specular{};
+		__m128 exponent{};
+	};
+
+	// A packet of pixels that passed the depth test, with everything a pixel shader can use to shade them
+	struct PixelShaderInput
+	{
+		// The interpolated attributes of every lane, the lanes after the last pixel repeat the first one
+		const Vertex_Out* pPixels[PacketSize]{};
+		const SoftwareMaterial* pMaterial{};
+
+		const PowLookupTable* pPowLookupTable{};
+		SpecularPowMode specularPowMode{};
+
+		// Samples a texture for every lane
+		ColorRGBPacket SampleTexture(const Texture* pTexture) const
+		{
+			return ColorRGBPacket::FromLanes(pTexture->Sample(pPixels[0]->uv), pTexture->Sample(pPixels[1]->uv), pTexture->Sample(pPixels[2]->uv), pTexture->Sample(pPixels[3]->uv));
+		}
+
+		// Samples the alpha channel of a texture for every lane
+		__m128 SampleAlpha(const Texture* pTexture) const
+		{
+			return _mm_setr_ps(pTexture->SampleAlpha(pPixels[0]->uv), pTexture->SampleAlpha(pPixels[1]->uv), pTexture->SampleAlpha(pPixels[2]->uv), pTexture->SampleAlpha(pPixels[3]->uv));
+		}
+
+		// Fetches the precomputed specular exponent for every lane
+		__m128 SampleExponent(const Texture* pTexture) const
+		{
+			return _mm_setr_ps(pTexture->SampleExponent(pPixels[0]->uv), pTexture->SampleExponent(pPixels[1]->uv), pTexture->SampleExponent(pPixels[2]->uv), pTexture->SampleExponent(pPixels[3]->uv));
+		}
+
+		// Collects an interpolated direction of every lane, for example &Vertex_Out::normal
+		Vector3Packet Gather(Vector3 Vertex_Out::* pAttribute) const
+		{
+			return Vector3Packet::FromLanes(pPixels[0]->*pAttribute, pPixels[1]->*pAttribute, pPixels[2]->*pAttribute, pPixels[3]->*pAttribute);
+		}
+
+		// Evaluates the specular power the way the renderer chose for this frame
+		__m128 SpecularPow(__m128 base, __m128 exponent) const
+		{
+			switch (specularPowMode)
+			{
+			case SpecularPowMode::Exact:
+			{
+				alignas(16) float bases[PacketSize];
+				alignas(16) float exponents[PacketSize];
+				_mm_store_ps(bases, base);
+				_mm_store_ps(exponents, exponent);
+				return _mm_setr_ps(powf(bases[0], exponents[0]), powf(bases[1], exponents[1]), powf(bases[2], exponents[2]), powf(bases[3], exponents[3]));
+			}
+			case SpecularPowMode::LookupTable:
+				return pPowLookupTable->Lookup(base, exponent);
+			default:
+				return FastPow(base, exponent);
+			}
+		}
+	};
+
+	// A shader of the software rasterizer, a type with only static functions
+	// ShadeVertex returns the vertex with its position in clip space, the rasterizer does the perspective divide
+	// GetVaryings lists the attributes ShadePixels reads for the shading modes, it has to be constexpr
+	// ShadePixels is specialized for the shading modes and returns the color of every lane, the rasterizer handles the depth and bounding box views
+	// The opacity of transparent meshes is the alpha of their diffuse texture, the rasterizer blends the color with it
+	template<typename Shader>
+	concept SoftwareShader = requires(const Vertex& vertex, const VertexShaderConstants& constants, const PixelShaderInput& input)
+	{
+		{ Shader::ShadeVertex(vertex, constants) } -> std::same_as<Vertex_Out>;
+		{ Shader::GetVaryings(ShadingModes{}) } -> std::same_as<Varyings>;
+		{ Shader::template ShadePixels<ShadingModes{}>(input) } -> std::same_as<ColorRGBPacket>;
+	};
+
+	// A shader whose pixels the deferred mode lights with every light instead of only the directional one
+	// ShadeSurface writes the G-buffer, the lighting pass lights it with the Phong model of SoftwarePhongShader
+	// GetSurfaceVaryings lists the attributes ShadeSurface reads, the lighting pass reconstructs the view direction itself
+	// Shaders without a surface color their pixels with ShadePixels in the deferred mode too, the lighting pass copies that color
+	template<typename Shader>
+	concept DeferredSoftwareShader = SoftwareShader<Shader> && requires(const PixelShaderInput& input)
+	{
+		{ Shader::GetSurfaceVaryings(ShadingModes{}) } -> std::same_as<Varyings>;
+		{ Shader::template ShadeSurface<ShadingModes{}>(input) } -> std::same_as<SurfacePacket>;
+	};
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <tuple>
+#include <type_traits>
+#include "SoftwarePhongShader.h"
+#include "SoftwareUnlitShader.h"
+
+namespace dae
+{
+	// Every shader the software rasterizer creates kernels for, custom shaders are added at the end
+	// The first shader is used by materials that do not select one
+	using SoftwareShaders = std::tuple<SoftwarePhongShader, SoftwareUnlitShader>;
+
+	// The index a material selects a shader with
+	template<SoftwareShader Shader, size_t ShaderIdx = 0>
+	constexpr uint32_t GetSoftwareShaderIdx()
+	{
+		static_assert(ShaderIdx < std::tuple_size_v<SoftwareShaders>, "The shader is not in SoftwareShaders");
+
+		if constexpr (std::is_same_v<Shader, std::tuple_element_t<ShaderIdx, SoftwareShaders>>) return ShaderIdx;
+		else return GetSoftwareShaderIdx<Shader, ShaderIdx + 1>();
+	}
+}
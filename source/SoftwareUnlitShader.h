@@ -0,0 +1,27 @@
+#pragma once
+#include "SoftwareShader.h"
+
+namespace dae
+{
+	// Only shows the diffuse texture, like the effect of the transparent meshes in the hardware rasterizer
+	struct SoftwareUnlitShader final
+	{
+		static Vertex_Out ShadeVertex(const Vertex& vertex, const VertexShaderConstants& constants)
+		{
+			Vertex_Out vOut{ {}, vertex.normal, vertex.tangent, vertex.uv, vertex.color };
+			vOut.position = constants.worldViewProjectionMatrix.TransformPoint({ vertex.position, 1.0f });
+			return vOut;
+		}
+
+		static constexpr Varyings GetVaryings(ShadingModes)
+		{
+			return Varyings{ true };
+		}
+
+		template<ShadingModes Modes>
+		static ColorRGBPacket ShadePixels(const PixelShaderInput& input)
+		{
+			return input.SampleTexture(input.pMaterial->pDiffuseTexture);
+		}
+	};
+}
@@ -86,6 +86,45 @@ namespace dae
 		return ColorRGB{ r / maxColorValue, g / maxColorValue, b / maxColorValue };
 	}
 
+	float Texture::SampleAlpha(const Vector2& uv) const
+	{
+		Uint8 r{};
+		Uint8 g{};
+		Uint8 b{};
+		Uint8 a{};
+
+		// Calculate the UV coordinates using clamp adressing mode
+		const int x{ std::min(static_cast<int>(std::clamp(uv.x, 0.0f, 1.0f) * m_pSurface->w), m_pSurface->w - 1) };
+		const int y{ std::min(static_cast<int>(std::clamp(uv.y, 0.0f, 1.0f) * m_pSurface->h), m_pSurface->h - 1) };
+
+		// Surfaces without an alpha channel are opaque
+		SDL_GetRGBA(m_pSurfacePixels[x + y * m_pSurface->w], m_pSurface->format, &r, &g, &b, &a);
+		return a / 255.0f;
+	}
+
+	void Texture::CreateExponentMap(float shininess)
+	{
+		m_Exponents.resize(static_cast<size_t>(m_pSurface->w * m_pSurface->h));
+		for (size_t texelIdx{}; texelIdx < m_Exponents.size(); ++texelIdx)
+		{
+			Uint8 r{};
+			Uint8 g{};
+			Uint8 b{};
+			SDL_GetRGB(m_pSurfacePixels[texelIdx], m_pSurface->format, &r, &g, &b);
+
+			m_Exponents[texelIdx] = shininess * r / 255.0f;
+		}
+	}
+
+	float Texture::SampleExponent(const Vector2& uv) const
+	{
+		// Calculate the UV coordinates using clamp adressing mode
+		const int x{ std::min(static_cast<int>(std::clamp(uv.x, 0.0f, 1.0f) * m_pSurface->w), m_pSurface->w - 1) };
+		const int y{ std::min(static_cast<int>(std::clamp(uv.y, 0.0f, 1.0f) * m_pSurface->h), m_pSurface->h - 1) };
+
+		return m_Exponents[x + y * m_pSurface->w];
+	}
+
 	ID3D11Texture2D* Texture::GetResource() const
 	{
 		return m_pResource;
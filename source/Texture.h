@@ -1,6 +1,7 @@
 #pragma once
 #include <SDL_surface.h>
 #include <string>
+#include <vector>
 #include "ColorRGB.h"
 
 namespace dae
@@ -23,6 +24,10 @@ namespace dae
 
 		// Software Rasterizer
 		ColorRGB Sample(const Vector2& uv) const;
+		float SampleAlpha(const Vector2& uv) const;
+		// Stores the red channel multiplied by the shininess for every texel, so shading a pixel only fetches its specular exponent
+		void CreateExponentMap(float shininess);
+		float SampleExponent(const Vector2& uv) const;
 
 		// Hardware Rasterizer
 		ID3D11Texture2D* GetResource() const;
@@ -34,6 +39,7 @@ namespace dae
 		// Software Rasterizer
 		SDL_Surface* m_pSurface{ nullptr };
 		uint32_t* m_pSurfacePixels{ nullptr };
+		std::vector<float> m_Exponents{};
 
 		// Hardware Rasterizer
 		TextureType m_Type{};
@@ -1,7 +1,10 @@
 #pragma once
 #include <fstream>
 #include "Math.h"
+#include "MathPacket.h"
 #include <vector>
+#include <map>
+#include <tuple>
 #include "DataTypes.h"
 
 namespace dae
@@ -21,15 +24,17 @@ namespace dae
 			std::vector<Vector3> normals{};
 			std::vector<Vector2> UVs{};
 
+			// Every unique position/uv/normal combination becomes one vertex that is shared between faces
+			std::map<std::tuple<size_t, size_t, size_t>, uint32_t> vertexLookup{};
+
 			vertices.clear();
 			indices.clear();
 
 			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			// start a while iteration ending when no command can be read anymore (end of file)
+			//read the first word of the string, use the >> operator (istream::operator>>) 
+			while (file >> sCommand)
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
 
 				//use conditional statements to process the different commands	
 				if (sCommand == "#")
@@ -67,12 +72,12 @@ namespace dae
 					//add the material index as attibute to the attribute array
 					//
 					// Faces or triangles
-					Vertex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
-
 					uint32_t tempIndices[3];
 					for (size_t iFace = 0; iFace < 3; iFace++)
 					{
+						Vertex vertex{};
+						size_t iPosition{}, iTexCoord{}, iNormal{};
+
 						// OBJ format uses 1-based arrays
 						file >> iPosition;
 						vertex.position = positions[iPosition - 1];
@@ -98,8 +103,18 @@ namespace dae
 							}
 						}
 
+						// Reuse the vertex if this combination was already read before (welding)
+						const auto vertexKey{ std::make_tuple(iPosition, iTexCoord, iNormal) };
+						const auto foundVertex{ vertexLookup.find(vertexKey) };
+						if (foundVertex != vertexLookup.end())
+						{
+							tempIndices[iFace] = foundVertex->second;
+							continue;
+						}
+
 						vertices.push_back(vertex);
 						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
+						vertexLookup.emplace(vertexKey, tempIndices[iFace]);
 						//indices.push_back(uint32_t(vertices.size()) - 1);
 					}
 
@@ -188,5 +203,29 @@ namespace dae
 
 			return ColorRGB{ phong, phong, phong };
 		}
+
+		// The same shading models for a packet of pixels, the power uses FastPow
+		inline ColorRGBPacket Lambert(float kd, const ColorRGBPacket& cd)
+		{
+			return cd * _mm_set1_ps(kd / PI);
+		}
+
+		// The power function can be replaced, it is called with the clamped dot of the reflected light and the view direction and the exponent
+		template<typename PowFunction>
+		inline ColorRGBPacket Phong(float ks, __m128 exp, const Vector3Packet& l, const Vector3Packet& v, const Vector3Packet& n, PowFunction pow)
+		{
+			const Vector3Packet reflectedLightVector{ Vector3Packet::Reflect(l, n) };
+
+			const __m128 reflectedViewDot{ Vector3Packet::DotClamped(reflectedLightVector, v) };
+
+			const __m128 phong{ _mm_mul_ps(_mm_set1_ps(ks), pow(reflectedViewDot, exp)) };
+
+			return ColorRGBPacket{ phong, phong, phong };
+		}
+
+		inline ColorRGBPacket Phong(float ks, __m128 exp, const Vector3Packet& l, const Vector3Packet& v, const Vector3Packet& n)
+		{
+			return Phong(ks, exp, l, v, n, FastPow);
+		}
 	}
 }
\ No newline at end of file
@@ -85,6 +85,13 @@ int main(int argc, char* args[])
 					}
 				}
 				else if (e.key.keysym.scancode == SDL_SCANCODE_0) pRenderer->ToggleMultiThreading();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_1) pRenderer->ToggleFleet();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_2) pRenderer->ToggleStreamedVehicle();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_3) pRenderer->ToggleSpecularPow();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_4) pRenderer->ToggleTransparencyMode();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_5) pRenderer->ToggleShadingRate();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_6) pRenderer->ToggleDeferredLighting();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_7) pRenderer->BenchmarkSpecularPow();
 				break;
 			default: ;
 			}
@@ -96,6 +103,10 @@ int main(int argc, char* args[])
 		//--------- Render ---------
 		pRenderer->Render();
 
+		//--------- Idle ---------
+		// Nothing changed this frame, wait for input (or at most one 60 Hz frame) instead of spinning
+		if (pRenderer->IsFrameUnchanged()) SDL_WaitEventTimeout(nullptr, 16);
+
 		//--------- Timer ---------
 		pTimer->Update();
 		printTimer += pTimer->GetElapsed();